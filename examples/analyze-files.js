@@ -19,8 +19,6 @@ if (process.argv.length < 4) {
   process.exit(1);
 }
 
-let currentFile;
-let samples = 0;
 const leadingBufferFrames = 10;
 const sampleRate = 16000;
 const samplesPerFrame = 480;
@@ -31,31 +29,22 @@ const recorder = new SpeechRecorder({
   leadingBufferFrames,
   samplesPerFrame,
   sampleRate,
-  onAudio: ({ audio, probability, volume }) => {
-    samples += audio.length;
-  },
-
-  onChunkStart: ({ audio }) => {
-    results[currentFile].speech.push([]);
-    results[currentFile].speech[results[currentFile].speech.length - 1].push(samples / sampleRate);
-  },
-
-  onChunkEnd: () => {
-    results[currentFile].speech[results[currentFile].speech.length - 1].push(samples / sampleRate);
-  },
 });
 
 fs.readdir(process.argv[2], async (error, files) => {
-  for (const file of files) {
-    if (!file.endsWith(".wav")) {
+  files = files.filter((file) => file.endsWith(".wav"));
+  console.log(`Processing ${files.length} files...`);
+  const processed = await recorder.processFiles(
+    files.map((file) => path.join(process.argv[2], file))
+  );
+
+  for (let i = 0; i < files.length; i++) {
+    if (processed[i].error !== undefined) {
+      console.log(processed[i].error);
       continue;
     }
 
-    currentFile = file;
-    samples = 0;
-    results[file] = { speech: [] };
-    console.log(`Processing ${file}...`);
-    recorder.processFile(path.join(process.argv[2], file));
+    results[files[i]] = { speech: processed[i].segments.map(({ start, end }) => [start, end]) };
   }
 
   let speechWindowTooSmall = [];
@@ -1,16 +1,28 @@
 #pragma once
 
 #include <napi.h>
+#include <readerwriterqueue.h>
 
 #include <atomic>
+#include <climits>
 #include <functional>
+#include <memory>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include "aligned.h"
 #include "chunk_processor.h"
+#include "pool.h"
+#include "resampler.h"
+
+using namespace moodycamel;
 
 struct SpeechRecorderCallbackData {
   std::string event = "";
+  // the device the event came from, or INT_MIN if it didn't come from one.
+  int device = INT_MIN;
   std::vector<short> audio;
   bool speaking = false;
   double volume = 0.0;
@@ -19,22 +31,112 @@ struct SpeechRecorderCallbackData {
   int consecutiveSilence = 0;
 };
 
+struct SpeechRecorderCallbackBatch {
+  std::vector<SpeechRecorderCallbackData*> events;
+};
+
+class SpeechRecorder;
+
+// state for a single call to processFileAsync, owned by its thread-safe
+// function and deleted by that function's finalizer.
+struct ProcessFileJob {
+  Napi::Promise::Deferred deferred;
+  Napi::ThreadSafeFunction threadSafeFunction;
+  std::thread thread;
+  std::string path;
+  bool failed = false;
+  SpeechRecorder* recorder = nullptr;
+  std::shared_ptr<speechrecorder::Pool<SpeechRecorderCallbackData>> pool;
+  speechrecorder::Pool<SpeechRecorderCallbackBatch> batchPool;
+  // the batch the job's thread is filling.
+  SpeechRecorderCallbackBatch* batch = nullptr;
+  std::unique_ptr<speechrecorder::ChunkProcessor> processor;
+
+  ProcessFileJob(Napi::Env env)
+      : deferred(Napi::Promise::Deferred::New(env)),
+        pool(std::make_shared<
+             speechrecorder::Pool<SpeechRecorderCallbackData>>()),
+        batchPool(8) {}
+};
+
+// the file a processFiles worker is on, and how far into it the worker is.
+struct ProcessFilesWorker {
+  std::vector<std::pair<double, double>>* segments = nullptr;
+  size_t samples = 0;
+};
+
+// state for a single call to processFiles. workers pull paths from a shared
+// index, so each file is processed by exactly one worker, and results are
+// stored by index so they come back in the order the paths were given.
+struct ProcessFilesJob {
+  Napi::Promise::Deferred deferred;
+  Napi::ThreadSafeFunction threadSafeFunction;
+  std::vector<std::unique_ptr<speechrecorder::ChunkProcessor>> processors;
+  std::vector<ProcessFilesWorker> workers;
+  std::vector<std::thread> threads;
+  std::vector<std::string> paths;
+  std::atomic<size_t> next;
+  std::vector<std::vector<std::pair<double, double>>> segments;
+  std::vector<char> failed;
+  SpeechRecorder* recorder = nullptr;
+
+  ProcessFilesJob(Napi::Env env)
+      : deferred(Napi::Promise::Deferred::New(env)), next(0) {}
+};
+
 class SpeechRecorder : public Napi::ObjectWrap<SpeechRecorder> {
  private:
   std::thread thread_;
   Napi::ThreadSafeFunction threadSafeFunction_;
   std::atomic<bool> stopped_;
-  BlockingReaderWriterQueue<SpeechRecorderCallbackData*> queue_;
+  // queues and pools only take one producer, so every device's processor
+  // has its own, and the dispatch thread drains all of the queues. ready_ is
+  // signaled once for each event, from any of the processors.
+  std::vector<std::unique_ptr<ReaderWriterQueue<SpeechRecorderCallbackData*>>>
+      queues_;
+  std::vector<std::shared_ptr<speechrecorder::Pool<SpeechRecorderCallbackData>>>
+      pools_;
+  spsc_sema::LightweightSemaphore ready_;
+  speechrecorder::Pool<SpeechRecorderCallbackBatch> batchPool_;
   Napi::FunctionReference callback_;
-  std::function<void(Napi::Env, Napi::Function, SpeechRecorderCallbackData*)>
+  std::function<void(Napi::Env, Napi::Function, SpeechRecorderCallbackBatch*)>
       threadSafeFunctionCallback_;
+  int batchFrames_;
+  int batchLatency_;
+  bool externalBuffers_;
   std::string modelPath_;
   speechrecorder::ChunkProcessorOptions options_;
-  speechrecorder::ChunkProcessor processor_;
-  std::unique_ptr<speechrecorder::ChunkProcessor> processFileProcessor_;
+  std::vector<int> devices_;
+  std::vector<std::unique_ptr<speechrecorder::ChunkProcessor>> processors_;
+  std::unique_ptr<speechrecorder::ChunkProcessor> inlineProcessor_;
+  std::vector<short> pushBuffer_;
+  std::vector<short> pushConversion_;
+  std::unique_ptr<speechrecorder::Resampler> pushResampler_;
+  std::vector<short> pushInterleaved_;
+  std::vector<short> pushResampled_;
 
+  speechrecorder::ChunkProcessorOptions CreateOptions(Napi::Object object);
+  std::unique_ptr<speechrecorder::AudioSource> CreateSource(
+      Napi::Object object,
+      const speechrecorder::ChunkProcessorOptions& options);
+  void Dispatch(
+      Napi::Env env, Napi::Function jsCallback,
+      SpeechRecorderCallbackData* data,
+      std::shared_ptr<speechrecorder::Pool<SpeechRecorderCallbackData>> pool);
+  void DispatchAudioBatch(Napi::Env env, Napi::Function jsCallback,
+                          SpeechRecorderCallbackData** events, size_t count);
+  speechrecorder::ChunkProcessor& InlineProcessor();
+  std::shared_ptr<speechrecorder::Pool<SpeechRecorderCallbackData>>& PoolFor(
+      int device);
+  void ProcessBuffer(const Napi::CallbackInfo& info);
   void ProcessFile(const Napi::CallbackInfo& info);
+  Napi::Value ProcessFileAsync(const Napi::CallbackInfo& info);
+  Napi::Value ProcessFiles(const Napi::CallbackInfo& info);
+  void Push(const Napi::CallbackInfo& info);
+  void PushSamples(Napi::Env env, Napi::Value value, int sampleRate,
+                   int channels);
   void Start(const Napi::CallbackInfo& info);
+  Napi::Value Stats(const Napi::CallbackInfo& info);
   void Stop(const Napi::CallbackInfo& info);
 
  public:
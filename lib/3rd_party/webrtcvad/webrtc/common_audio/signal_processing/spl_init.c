@@ -9,7 +9,7 @@
  */
 
 /* The global function contained in this file initializes SPL function
- * pointers, currently only for ARM platforms.
+ * pointers, for ARM, MIPS and x86 platforms.
  *
  * Some code came from common/rtcd.c in the WebM project.
  */
@@ -44,6 +44,36 @@ static void InitPointersToC(void) {
 }
 #endif
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+/* Initialize function pointers to the SSE4.1 version. */
+static void InitPointersToSse41(void) {
+  WebRtcSpl_MaxAbsValueW16 = WebRtcSpl_MaxAbsValueW16Sse41;
+  WebRtcSpl_MaxAbsValueW32 = WebRtcSpl_MaxAbsValueW32Sse41;
+  WebRtcSpl_MaxValueW16 = WebRtcSpl_MaxValueW16Sse41;
+  WebRtcSpl_MaxValueW32 = WebRtcSpl_MaxValueW32Sse41;
+  WebRtcSpl_MinValueW16 = WebRtcSpl_MinValueW16Sse41;
+  WebRtcSpl_MinValueW32 = WebRtcSpl_MinValueW32Sse41;
+  WebRtcSpl_CrossCorrelation = WebRtcSpl_CrossCorrelationSse41;
+  WebRtcSpl_DownsampleFast = WebRtcSpl_DownsampleFastSse41;
+  WebRtcSpl_ScaleAndAddVectorsWithRound =
+      WebRtcSpl_ScaleAndAddVectorsWithRoundSse41;
+}
+
+/* Initialize function pointers to the AVX2 version. */
+static void InitPointersToAvx2(void) {
+  WebRtcSpl_MaxAbsValueW16 = WebRtcSpl_MaxAbsValueW16Avx2;
+  WebRtcSpl_MaxAbsValueW32 = WebRtcSpl_MaxAbsValueW32Avx2;
+  WebRtcSpl_MaxValueW16 = WebRtcSpl_MaxValueW16Avx2;
+  WebRtcSpl_MaxValueW32 = WebRtcSpl_MaxValueW32Avx2;
+  WebRtcSpl_MinValueW16 = WebRtcSpl_MinValueW16Avx2;
+  WebRtcSpl_MinValueW32 = WebRtcSpl_MinValueW32Avx2;
+  WebRtcSpl_CrossCorrelation = WebRtcSpl_CrossCorrelationAvx2;
+  WebRtcSpl_DownsampleFast = WebRtcSpl_DownsampleFastAvx2;
+  WebRtcSpl_ScaleAndAddVectorsWithRound =
+      WebRtcSpl_ScaleAndAddVectorsWithRoundAvx2;
+}
+#endif
+
 #if defined(WEBRTC_HAS_NEON)
 /* Initialize function pointers to the Neon version. */
 static void InitPointersToNeon(void) {
@@ -87,6 +117,14 @@ static void InitFunctionPointers(void) {
   InitPointersToNeon();
 #elif defined(MIPS32_LE)
   InitPointersToMIPS();
+#elif defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kAVX2)) {
+    InitPointersToAvx2();
+  } else if (WebRtc_GetCPUInfo(kSSE4_1)) {
+    InitPointersToSse41();
+  } else {
+    InitPointersToC();
+  }
 #else
   InitPointersToC();
 #endif  /* WEBRTC_HAS_NEON */
@@ -0,0 +1,689 @@
+/*
+ *  Copyright (c) 2012 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/* SSE4.1 and AVX2 versions of the functions in the SPL function pointer
+ * table. WebRtcSpl_Init only selects them when CPUID reports support, so they
+ * are compiled with per-function target attributes rather than by raising the
+ * baseline for the whole library. Each one produces exactly the same output
+ * as its C version, including 32-bit wraparound in the accumulating ones.
+ */
+
+#include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+
+#include <immintrin.h>
+#include <stdlib.h>
+
+#include "webrtc/rtc_base/checks.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#endif
+
+/* Filters longer than this fall back to the C version of DownsampleFast. */
+#define MAX_DOWNSAMPLE_COEFFICIENTS 64
+
+/* Horizontal reductions, done through memory since they run once per call. */
+
+static int16_t MaxW16(const int16_t* values, size_t length) {
+  int16_t maximum = WEBRTC_SPL_WORD16_MIN;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    if (values[i] > maximum)
+      maximum = values[i];
+  }
+  return maximum;
+}
+
+static int16_t MinW16(const int16_t* values, size_t length) {
+  int16_t minimum = WEBRTC_SPL_WORD16_MAX;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    if (values[i] < minimum)
+      minimum = values[i];
+  }
+  return minimum;
+}
+
+static uint16_t MaxU16(const uint16_t* values, size_t length) {
+  uint16_t maximum = 0;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    if (values[i] > maximum)
+      maximum = values[i];
+  }
+  return maximum;
+}
+
+static int32_t MaxW32(const int32_t* values, size_t length) {
+  int32_t maximum = WEBRTC_SPL_WORD32_MIN;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    if (values[i] > maximum)
+      maximum = values[i];
+  }
+  return maximum;
+}
+
+static int32_t MinW32(const int32_t* values, size_t length) {
+  int32_t minimum = WEBRTC_SPL_WORD32_MAX;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    if (values[i] < minimum)
+      minimum = values[i];
+  }
+  return minimum;
+}
+
+static uint32_t MaxU32(const uint32_t* values, size_t length) {
+  uint32_t maximum = 0;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    if (values[i] > maximum)
+      maximum = values[i];
+  }
+  return maximum;
+}
+
+/* Sums are unsigned so that wraparound is defined, as it is in the vectors. */
+static uint32_t SumU32(const uint32_t* values, size_t length) {
+  uint32_t sum = 0;
+  size_t i;
+  for (i = 0; i < length; i++) {
+    sum += values[i];
+  }
+  return sum;
+}
+
+/* abs(-32768) and abs(0x80000000) are 0x8000 and 0x80000000, which are the
+ * right magnitudes when compared as unsigned, and are then clamped just like
+ * the C versions do.
+ */
+
+TARGET_SSE41
+int16_t WebRtcSpl_MaxAbsValueW16Sse41(const int16_t* vector, size_t length) {
+  __m128i maximums = _mm_setzero_si128();
+  uint16_t lanes[8];
+  uint32_t maximum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 8 <= length; i += 8) {
+    __m128i values = _mm_loadu_si128((const __m128i*)(vector + i));
+    maximums = _mm_max_epu16(maximums, _mm_abs_epi16(values));
+  }
+
+  _mm_storeu_si128((__m128i*)lanes, maximums);
+  maximum = MaxU16(lanes, 8);
+  for (; i < length; i++) {
+    uint32_t absolute = (uint32_t)abs((int)vector[i]);
+    if (absolute > maximum)
+      maximum = absolute;
+  }
+
+  return (int16_t)WEBRTC_SPL_MIN(maximum, WEBRTC_SPL_WORD16_MAX);
+}
+
+TARGET_AVX2
+int16_t WebRtcSpl_MaxAbsValueW16Avx2(const int16_t* vector, size_t length) {
+  __m256i maximums = _mm256_setzero_si256();
+  uint16_t lanes[16];
+  uint32_t maximum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 16 <= length; i += 16) {
+    __m256i values = _mm256_loadu_si256((const __m256i*)(vector + i));
+    maximums = _mm256_max_epu16(maximums, _mm256_abs_epi16(values));
+  }
+
+  _mm256_storeu_si256((__m256i*)lanes, maximums);
+  maximum = MaxU16(lanes, 16);
+  for (; i < length; i++) {
+    uint32_t absolute = (uint32_t)abs((int)vector[i]);
+    if (absolute > maximum)
+      maximum = absolute;
+  }
+
+  return (int16_t)WEBRTC_SPL_MIN(maximum, WEBRTC_SPL_WORD16_MAX);
+}
+
+TARGET_SSE41
+int32_t WebRtcSpl_MaxAbsValueW32Sse41(const int32_t* vector, size_t length) {
+  __m128i maximums = _mm_setzero_si128();
+  uint32_t lanes[4];
+  uint32_t maximum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 4 <= length; i += 4) {
+    __m128i values = _mm_loadu_si128((const __m128i*)(vector + i));
+    maximums = _mm_max_epu32(maximums, _mm_abs_epi32(values));
+  }
+
+  _mm_storeu_si128((__m128i*)lanes, maximums);
+  maximum = MaxU32(lanes, 4);
+  for (; i < length; i++) {
+    uint32_t absolute = (uint32_t)abs((int)vector[i]);
+    if (absolute > maximum)
+      maximum = absolute;
+  }
+
+  maximum = WEBRTC_SPL_MIN(maximum, WEBRTC_SPL_WORD32_MAX);
+  return (int32_t)maximum;
+}
+
+TARGET_AVX2
+int32_t WebRtcSpl_MaxAbsValueW32Avx2(const int32_t* vector, size_t length) {
+  __m256i maximums = _mm256_setzero_si256();
+  uint32_t lanes[8];
+  uint32_t maximum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 8 <= length; i += 8) {
+    __m256i values = _mm256_loadu_si256((const __m256i*)(vector + i));
+    maximums = _mm256_max_epu32(maximums, _mm256_abs_epi32(values));
+  }
+
+  _mm256_storeu_si256((__m256i*)lanes, maximums);
+  maximum = MaxU32(lanes, 8);
+  for (; i < length; i++) {
+    uint32_t absolute = (uint32_t)abs((int)vector[i]);
+    if (absolute > maximum)
+      maximum = absolute;
+  }
+
+  maximum = WEBRTC_SPL_MIN(maximum, WEBRTC_SPL_WORD32_MAX);
+  return (int32_t)maximum;
+}
+
+TARGET_SSE41
+int16_t WebRtcSpl_MaxValueW16Sse41(const int16_t* vector, size_t length) {
+  __m128i maximums = _mm_set1_epi16(WEBRTC_SPL_WORD16_MIN);
+  int16_t lanes[8];
+  int16_t maximum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 8 <= length; i += 8) {
+    maximums = _mm_max_epi16(maximums,
+                             _mm_loadu_si128((const __m128i*)(vector + i)));
+  }
+
+  _mm_storeu_si128((__m128i*)lanes, maximums);
+  maximum = MaxW16(lanes, 8);
+  for (; i < length; i++) {
+    if (vector[i] > maximum)
+      maximum = vector[i];
+  }
+  return maximum;
+}
+
+TARGET_AVX2
+int16_t WebRtcSpl_MaxValueW16Avx2(const int16_t* vector, size_t length) {
+  __m256i maximums = _mm256_set1_epi16(WEBRTC_SPL_WORD16_MIN);
+  int16_t lanes[16];
+  int16_t maximum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 16 <= length; i += 16) {
+    maximums = _mm256_max_epi16(
+        maximums, _mm256_loadu_si256((const __m256i*)(vector + i)));
+  }
+
+  _mm256_storeu_si256((__m256i*)lanes, maximums);
+  maximum = MaxW16(lanes, 16);
+  for (; i < length; i++) {
+    if (vector[i] > maximum)
+      maximum = vector[i];
+  }
+  return maximum;
+}
+
+TARGET_SSE41
+int32_t WebRtcSpl_MaxValueW32Sse41(const int32_t* vector, size_t length) {
+  __m128i maximums = _mm_set1_epi32(WEBRTC_SPL_WORD32_MIN);
+  int32_t lanes[4];
+  int32_t maximum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 4 <= length; i += 4) {
+    maximums = _mm_max_epi32(maximums,
+                             _mm_loadu_si128((const __m128i*)(vector + i)));
+  }
+
+  _mm_storeu_si128((__m128i*)lanes, maximums);
+  maximum = MaxW32(lanes, 4);
+  for (; i < length; i++) {
+    if (vector[i] > maximum)
+      maximum = vector[i];
+  }
+  return maximum;
+}
+
+TARGET_AVX2
+int32_t WebRtcSpl_MaxValueW32Avx2(const int32_t* vector, size_t length) {
+  __m256i maximums = _mm256_set1_epi32(WEBRTC_SPL_WORD32_MIN);
+  int32_t lanes[8];
+  int32_t maximum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 8 <= length; i += 8) {
+    maximums = _mm256_max_epi32(
+        maximums, _mm256_loadu_si256((const __m256i*)(vector + i)));
+  }
+
+  _mm256_storeu_si256((__m256i*)lanes, maximums);
+  maximum = MaxW32(lanes, 8);
+  for (; i < length; i++) {
+    if (vector[i] > maximum)
+      maximum = vector[i];
+  }
+  return maximum;
+}
+
+TARGET_SSE41
+int16_t WebRtcSpl_MinValueW16Sse41(const int16_t* vector, size_t length) {
+  __m128i minimums = _mm_set1_epi16(WEBRTC_SPL_WORD16_MAX);
+  int16_t lanes[8];
+  int16_t minimum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 8 <= length; i += 8) {
+    minimums = _mm_min_epi16(minimums,
+                             _mm_loadu_si128((const __m128i*)(vector + i)));
+  }
+
+  _mm_storeu_si128((__m128i*)lanes, minimums);
+  minimum = MinW16(lanes, 8);
+  for (; i < length; i++) {
+    if (vector[i] < minimum)
+      minimum = vector[i];
+  }
+  return minimum;
+}
+
+TARGET_AVX2
+int16_t WebRtcSpl_MinValueW16Avx2(const int16_t* vector, size_t length) {
+  __m256i minimums = _mm256_set1_epi16(WEBRTC_SPL_WORD16_MAX);
+  int16_t lanes[16];
+  int16_t minimum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 16 <= length; i += 16) {
+    minimums = _mm256_min_epi16(
+        minimums, _mm256_loadu_si256((const __m256i*)(vector + i)));
+  }
+
+  _mm256_storeu_si256((__m256i*)lanes, minimums);
+  minimum = MinW16(lanes, 16);
+  for (; i < length; i++) {
+    if (vector[i] < minimum)
+      minimum = vector[i];
+  }
+  return minimum;
+}
+
+TARGET_SSE41
+int32_t WebRtcSpl_MinValueW32Sse41(const int32_t* vector, size_t length) {
+  __m128i minimums = _mm_set1_epi32(WEBRTC_SPL_WORD32_MAX);
+  int32_t lanes[4];
+  int32_t minimum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 4 <= length; i += 4) {
+    minimums = _mm_min_epi32(minimums,
+                             _mm_loadu_si128((const __m128i*)(vector + i)));
+  }
+
+  _mm_storeu_si128((__m128i*)lanes, minimums);
+  minimum = MinW32(lanes, 4);
+  for (; i < length; i++) {
+    if (vector[i] < minimum)
+      minimum = vector[i];
+  }
+  return minimum;
+}
+
+TARGET_AVX2
+int32_t WebRtcSpl_MinValueW32Avx2(const int32_t* vector, size_t length) {
+  __m256i minimums = _mm256_set1_epi32(WEBRTC_SPL_WORD32_MAX);
+  int32_t lanes[8];
+  int32_t minimum;
+  size_t i = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  for (; i + 8 <= length; i += 8) {
+    minimums = _mm256_min_epi32(
+        minimums, _mm256_loadu_si256((const __m256i*)(vector + i)));
+  }
+
+  _mm256_storeu_si256((__m256i*)lanes, minimums);
+  minimum = MinW32(lanes, 8);
+  for (; i < length; i++) {
+    if (vector[i] < minimum)
+      minimum = vector[i];
+  }
+  return minimum;
+}
+
+/* Each element is in1 * scale1 + in2 * scale2, which madd computes from the
+ * interleaved inputs and scales. The result is truncated to 16 bits like the
+ * C cast, by sign extending the low half before the (then lossless) pack.
+ */
+
+TARGET_SSE41
+int WebRtcSpl_ScaleAndAddVectorsWithRoundSse41(const int16_t* in_vector1,
+                                               int16_t in_vector1_scale,
+                                               const int16_t* in_vector2,
+                                               int16_t in_vector2_scale,
+                                               int right_shifts,
+                                               int16_t* out_vector,
+                                               size_t length) {
+  size_t i = 0;
+  int round_value = (1 << right_shifts) >> 1;
+  __m128i scales, round, shift;
+
+  if (in_vector1 == NULL || in_vector2 == NULL || out_vector == NULL ||
+      length == 0 || right_shifts < 0) {
+    return -1;
+  }
+
+  scales = _mm_set1_epi32((int32_t)(((uint32_t)(uint16_t)in_vector2_scale
+                                     << 16) |
+                                    (uint16_t)in_vector1_scale));
+  round = _mm_set1_epi32(round_value);
+  shift = _mm_cvtsi32_si128(right_shifts);
+  for (; i + 8 <= length; i += 8) {
+    __m128i in1 = _mm_loadu_si128((const __m128i*)(in_vector1 + i));
+    __m128i in2 = _mm_loadu_si128((const __m128i*)(in_vector2 + i));
+    __m128i low = _mm_madd_epi16(_mm_unpacklo_epi16(in1, in2), scales);
+    __m128i high = _mm_madd_epi16(_mm_unpackhi_epi16(in1, in2), scales);
+    low = _mm_sra_epi32(_mm_add_epi32(low, round), shift);
+    high = _mm_sra_epi32(_mm_add_epi32(high, round), shift);
+    low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+    high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+    _mm_storeu_si128((__m128i*)(out_vector + i), _mm_packs_epi32(low, high));
+  }
+
+  for (; i < length; i++) {
+    out_vector[i] = (int16_t)((
+        in_vector1[i] * in_vector1_scale + in_vector2[i] * in_vector2_scale +
+        round_value) >> right_shifts);
+  }
+
+  return 0;
+}
+
+TARGET_AVX2
+int WebRtcSpl_ScaleAndAddVectorsWithRoundAvx2(const int16_t* in_vector1,
+                                              int16_t in_vector1_scale,
+                                              const int16_t* in_vector2,
+                                              int16_t in_vector2_scale,
+                                              int right_shifts,
+                                              int16_t* out_vector,
+                                              size_t length) {
+  size_t i = 0;
+  int round_value = (1 << right_shifts) >> 1;
+  __m256i scales, round;
+  __m128i shift;
+
+  if (in_vector1 == NULL || in_vector2 == NULL || out_vector == NULL ||
+      length == 0 || right_shifts < 0) {
+    return -1;
+  }
+
+  scales = _mm256_set1_epi32((int32_t)(((uint32_t)(uint16_t)in_vector2_scale
+                                        << 16) |
+                                       (uint16_t)in_vector1_scale));
+  round = _mm256_set1_epi32(round_value);
+  shift = _mm_cvtsi32_si128(right_shifts);
+  for (; i + 16 <= length; i += 16) {
+    /* unpack and pack both work within 128-bit lanes, so the output comes
+     * back in the same order as the input.
+     */
+    __m256i in1 = _mm256_loadu_si256((const __m256i*)(in_vector1 + i));
+    __m256i in2 = _mm256_loadu_si256((const __m256i*)(in_vector2 + i));
+    __m256i low = _mm256_madd_epi16(_mm256_unpacklo_epi16(in1, in2), scales);
+    __m256i high = _mm256_madd_epi16(_mm256_unpackhi_epi16(in1, in2), scales);
+    low = _mm256_sra_epi32(_mm256_add_epi32(low, round), shift);
+    high = _mm256_sra_epi32(_mm256_add_epi32(high, round), shift);
+    low = _mm256_srai_epi32(_mm256_slli_epi32(low, 16), 16);
+    high = _mm256_srai_epi32(_mm256_slli_epi32(high, 16), 16);
+    _mm256_storeu_si256((__m256i*)(out_vector + i),
+                        _mm256_packs_epi32(low, high));
+  }
+
+  for (; i < length; i++) {
+    out_vector[i] = (int16_t)((
+        in_vector1[i] * in_vector1_scale + in_vector2[i] * in_vector2_scale +
+        round_value) >> right_shifts);
+  }
+
+  return 0;
+}
+
+/* The C version shifts each product before summing, so the products are
+ * widened to 32 bits from their low and high halves, then shifted and added.
+ */
+
+TARGET_SSE41
+void WebRtcSpl_CrossCorrelationSse41(int32_t* cross_correlation,
+                                     const int16_t* seq1,
+                                     const int16_t* seq2,
+                                     size_t dim_seq,
+                                     size_t dim_cross_correlation,
+                                     int right_shifts,
+                                     int step_seq2) {
+  __m128i shift = _mm_cvtsi32_si128(right_shifts);
+  uint32_t lanes[4];
+  size_t i = 0, j = 0;
+
+  for (i = 0; i < dim_cross_correlation; i++) {
+    __m128i sums = _mm_setzero_si128();
+    uint32_t corr;
+    for (j = 0; j + 8 <= dim_seq; j += 8) {
+      __m128i a = _mm_loadu_si128((const __m128i*)(seq1 + j));
+      __m128i b = _mm_loadu_si128((const __m128i*)(seq2 + j));
+      __m128i low = _mm_mullo_epi16(a, b);
+      __m128i high = _mm_mulhi_epi16(a, b);
+      sums = _mm_add_epi32(
+          sums, _mm_sra_epi32(_mm_unpacklo_epi16(low, high), shift));
+      sums = _mm_add_epi32(
+          sums, _mm_sra_epi32(_mm_unpackhi_epi16(low, high), shift));
+    }
+
+    _mm_storeu_si128((__m128i*)lanes, sums);
+    corr = SumU32(lanes, 4);
+    for (; j < dim_seq; j++)
+      corr += (uint32_t)((seq1[j] * seq2[j]) >> right_shifts);
+    seq2 += step_seq2;
+    *cross_correlation++ = (int32_t)corr;
+  }
+}
+
+TARGET_AVX2
+void WebRtcSpl_CrossCorrelationAvx2(int32_t* cross_correlation,
+                                    const int16_t* seq1,
+                                    const int16_t* seq2,
+                                    size_t dim_seq,
+                                    size_t dim_cross_correlation,
+                                    int right_shifts,
+                                    int step_seq2) {
+  __m128i shift = _mm_cvtsi32_si128(right_shifts);
+  uint32_t lanes[8];
+  size_t i = 0, j = 0;
+
+  for (i = 0; i < dim_cross_correlation; i++) {
+    __m256i sums = _mm256_setzero_si256();
+    uint32_t corr;
+    for (j = 0; j + 16 <= dim_seq; j += 16) {
+      __m256i a = _mm256_loadu_si256((const __m256i*)(seq1 + j));
+      __m256i b = _mm256_loadu_si256((const __m256i*)(seq2 + j));
+      __m256i low = _mm256_mullo_epi16(a, b);
+      __m256i high = _mm256_mulhi_epi16(a, b);
+      sums = _mm256_add_epi32(
+          sums, _mm256_sra_epi32(_mm256_unpacklo_epi16(low, high), shift));
+      sums = _mm256_add_epi32(
+          sums, _mm256_sra_epi32(_mm256_unpackhi_epi16(low, high), shift));
+    }
+
+    _mm256_storeu_si256((__m256i*)lanes, sums);
+    corr = SumU32(lanes, 8);
+    for (; j < dim_seq; j++)
+      corr += (uint32_t)((seq1[j] * seq2[j]) >> right_shifts);
+    seq2 += step_seq2;
+    *cross_correlation++ = (int32_t)corr;
+  }
+}
+
+/* Each output is a dot product of the reversed coefficients with the input
+ * samples that end at the output's position, so the coefficients are reversed
+ * once and then multiplied and summed in pairs with madd.
+ */
+
+TARGET_SSE41
+int WebRtcSpl_DownsampleFastSse41(const int16_t* data_in,
+                                  size_t data_in_length,
+                                  int16_t* data_out,
+                                  size_t data_out_length,
+                                  const int16_t* __restrict coefficients,
+                                  size_t coefficients_length,
+                                  int factor,
+                                  size_t delay) {
+  int16_t reversed[MAX_DOWNSAMPLE_COEFFICIENTS];
+  uint32_t lanes[4];
+  size_t i = 0;
+  size_t j = 0;
+  size_t endpos = delay + factor * (data_out_length - 1) + 1;
+
+  // Return error if any of the running conditions doesn't meet.
+  if (data_out_length == 0 || coefficients_length == 0
+                           || data_in_length < endpos) {
+    return -1;
+  }
+
+  if (coefficients_length > MAX_DOWNSAMPLE_COEFFICIENTS) {
+    return WebRtcSpl_DownsampleFastC(data_in, data_in_length, data_out,
+                                     data_out_length, coefficients,
+                                     coefficients_length, factor, delay);
+  }
+
+  for (j = 0; j < coefficients_length; j++) {
+    reversed[j] = coefficients[coefficients_length - 1 - j];
+  }
+
+  for (i = delay; i < endpos; i += factor) {
+    // Negative positions hold the filter state, as in the C version.
+    const int16_t* window =
+        &data_in[(ptrdiff_t)i - (ptrdiff_t)(coefficients_length - 1)];
+    __m128i sums = _mm_setzero_si128();
+    uint32_t out_u32;
+    for (j = 0; j + 8 <= coefficients_length; j += 8) {
+      sums = _mm_add_epi32(
+          sums, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(reversed + j)),
+                               _mm_loadu_si128((const __m128i*)(window + j))));
+    }
+
+    _mm_storeu_si128((__m128i*)lanes, sums);
+    out_u32 = 2048 + SumU32(lanes, 4);  // Round value, 0.5 in Q12.
+    for (; j < coefficients_length; j++) {
+      out_u32 += (uint32_t)(reversed[j] * window[j]);
+    }
+
+    // Saturate and store the output.
+    *data_out++ = WebRtcSpl_SatW32ToW16((int32_t)out_u32 >> 12);
+  }
+
+  return 0;
+}
+
+TARGET_AVX2
+int WebRtcSpl_DownsampleFastAvx2(const int16_t* data_in,
+                                 size_t data_in_length,
+                                 int16_t* data_out,
+                                 size_t data_out_length,
+                                 const int16_t* __restrict coefficients,
+                                 size_t coefficients_length,
+                                 int factor,
+                                 size_t delay) {
+  int16_t reversed[MAX_DOWNSAMPLE_COEFFICIENTS];
+  uint32_t lanes[8];
+  size_t i = 0;
+  size_t j = 0;
+  size_t endpos = delay + factor * (data_out_length - 1) + 1;
+
+  // Return error if any of the running conditions doesn't meet.
+  if (data_out_length == 0 || coefficients_length == 0
+                           || data_in_length < endpos) {
+    return -1;
+  }
+
+  if (coefficients_length > MAX_DOWNSAMPLE_COEFFICIENTS) {
+    return WebRtcSpl_DownsampleFastC(data_in, data_in_length, data_out,
+                                     data_out_length, coefficients,
+                                     coefficients_length, factor, delay);
+  }
+
+  for (j = 0; j < coefficients_length; j++) {
+    reversed[j] = coefficients[coefficients_length - 1 - j];
+  }
+
+  for (i = delay; i < endpos; i += factor) {
+    // Negative positions hold the filter state, as in the C version.
+    const int16_t* window =
+        &data_in[(ptrdiff_t)i - (ptrdiff_t)(coefficients_length - 1)];
+    __m256i sums = _mm256_setzero_si256();
+    uint32_t out_u32;
+    for (j = 0; j + 16 <= coefficients_length; j += 16) {
+      sums = _mm256_add_epi32(
+          sums,
+          _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(reversed + j)),
+                            _mm256_loadu_si256((const __m256i*)(window + j))));
+    }
+
+    _mm256_storeu_si256((__m256i*)lanes, sums);
+    out_u32 = 2048 + SumU32(lanes, 8);  // Round value, 0.5 in Q12.
+    for (; j < coefficients_length; j++) {
+      out_u32 += (uint32_t)(reversed[j] * window[j]);
+    }
+
+    // Saturate and store the output.
+    *data_out++ = WebRtcSpl_SatW32ToW16((int32_t)out_u32 >> 12);
+  }
+
+  return 0;
+}
+
+#endif  // WEBRTC_ARCH_X86_FAMILY
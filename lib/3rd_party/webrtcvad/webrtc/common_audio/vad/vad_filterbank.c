@@ -11,9 +11,19 @@
 #include "webrtc/common_audio/vad/vad_filterbank.h"
 
 #include "webrtc/rtc_base/checks.h"
+#include "webrtc/rtc_base/system/arch.h"
 #include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
 
-// Constants used in LogOfEnergy().
+// SSE2 is part of the x86-64 baseline, so it needs no runtime detection.
+#if defined(WEBRTC_ARCH_X86_FAMILY) &&                     \
+    (defined(__SSE2__) || defined(_M_X64) ||               \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define WEBRTC_VAD_FILTERBANK_SSE2
+#include <emmintrin.h>
+#include <string.h>
+#endif
+
+// Constants used in LogOfScaledEnergy().
 static const int16_t kLogConst = 24660;  // 160*log10(2) in Q9.
 static const int16_t kLogEnergyIntPart = 14336;  // 14 in Q10
 
@@ -138,32 +148,19 @@ static void SplitFilter(const int16_t* data_in, size_t data_length,
   }
 }
 
-// Calculates the energy of |data_in| in dB, and also updates an overall
-// |total_energy| if necessary.
+// Converts an energy from WebRtcSpl_Energy() to dB, and also updates an
+// overall |total_energy| if necessary.
 //
-// - data_in      [i]   : Input audio data for energy calculation.
-// - data_length  [i]   : Length of input data.
+// - energy       [i]   : Energy of the input data, in Q(-|tot_rshifts|).
+// - tot_rshifts  [i]   : Number of right shifts performed on |energy|.
 // - offset       [i]   : Offset value added to |log_energy|.
-// - total_energy [i/o] : An external energy updated with the energy of
-//                        |data_in|.
+// - total_energy [i/o] : An external energy updated with |energy|.
 //                        NOTE: |total_energy| is only updated if
 //                        |total_energy| <= |kMinEnergy|.
-// - log_energy   [o]   : 10 * log10("energy of |data_in|") given in Q4.
-static void LogOfEnergy(const int16_t* data_in, size_t data_length,
-                        int16_t offset, int16_t* total_energy,
-                        int16_t* log_energy) {
-  // |tot_rshifts| accumulates the number of right shifts performed on |energy|.
-  int tot_rshifts = 0;
-  // The |energy| will be normalized to 15 bits. We use unsigned integer because
-  // we eventually will mask out the fractional part.
-  uint32_t energy = 0;
-
-  RTC_DCHECK(data_in);
-  RTC_DCHECK_GT(data_length, 0);
-
-  energy = (uint32_t) WebRtcSpl_Energy((int16_t*) data_in, data_length,
-                                       &tot_rshifts);
-
+// - log_energy   [o]   : 10 * log10(|energy|) given in Q4.
+static void LogOfScaledEnergy(uint32_t energy, int tot_rshifts,
+                              int16_t offset, int16_t* total_energy,
+                              int16_t* log_energy) {
   if (energy != 0) {
     // By construction, normalizing to 15 bits is equivalent with 17 leading
     // zeros of an unsigned 32 bit value.
@@ -240,8 +237,36 @@ static void LogOfEnergy(const int16_t* data_in, size_t data_length,
   }
 }
 
-int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
-                                    size_t data_length, int16_t* features) {
+// Calculates the energy of |data_in| in dB, and also updates an overall
+// |total_energy| if necessary.
+//
+// - data_in      [i]   : Input audio data for energy calculation.
+// - data_length  [i]   : Length of input data.
+// - offset       [i]   : Offset value added to |log_energy|.
+// - total_energy [i/o] : An external energy updated with the energy of
+//                        |data_in|.
+//                        NOTE: |total_energy| is only updated if
+//                        |total_energy| <= |kMinEnergy|.
+// - log_energy   [o]   : 10 * log10("energy of |data_in|") given in Q4.
+static void LogOfEnergy(const int16_t* data_in, size_t data_length,
+                        int16_t offset, int16_t* total_energy,
+                        int16_t* log_energy) {
+  // |tot_rshifts| accumulates the number of right shifts performed on |energy|.
+  int tot_rshifts = 0;
+  // The |energy| will be normalized to 15 bits. We use unsigned integer because
+  // we eventually will mask out the fractional part.
+  uint32_t energy = 0;
+
+  RTC_DCHECK(data_in);
+  RTC_DCHECK_GT(data_length, 0);
+
+  energy = (uint32_t) WebRtcSpl_Energy((int16_t*) data_in, data_length,
+                                       &tot_rshifts);
+  LogOfScaledEnergy(energy, tot_rshifts, offset, total_energy, log_energy);
+}
+
+int16_t WebRtcVad_CalculateFeaturesC(VadInstT* self, const int16_t* data_in,
+                                     size_t data_length, int16_t* features) {
   int16_t total_energy = 0;
   // We expect |data_length| to be 80, 160 or 240 samples, which corresponds to
   // 10, 20 or 30 ms in 8 kHz. Therefore, the intermediate downsampled data will
@@ -327,3 +352,229 @@ int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
 
   return total_energy;
 }
+
+#if defined(WEBRTC_VAD_FILTERBANK_SSE2)
+
+// Loads two consecutive samples into the low 32 bits of a vector.
+static __m128i LoadPair(const int16_t* data) {
+  int32_t pair;
+  memcpy(&pair, data, sizeof(pair));
+  return _mm_cvtsi32_si128(pair);
+}
+
+// Runs SplitFilter() on one or two bands at once. The upper and lower
+// all-pass filters of each band are recursive, but independent of each other,
+// so they are computed in the four 32-bit lanes of a vector as
+// (upper 0, lower 0, upper 1, lower 1). The arithmetic in each lane is the
+// same as in AllPassFilter(), so the output is bit-exact.
+//
+// - data_in      [i]   : Input audio data of each band.
+// - data_length  [i]   : Length of |data_in|, the same for both bands.
+// - bands        [i]   : Number of bands to split, 1 or 2.
+// - upper_state  [i/o] : State of the upper filters, one per band.
+// - lower_state  [i/o] : State of the lower filters, one per band.
+// - hp_data_out  [o]   : Output audio data of the upper half of each band.
+// - lp_data_out  [o]   : Output audio data of the lower half of each band.
+static void SplitFiltersSse2(const int16_t* const* data_in, size_t data_length,
+                             int bands, int16_t* upper_state,
+                             int16_t* lower_state, int16_t* const* hp_data_out,
+                             int16_t* const* lp_data_out) {
+  size_t i;
+  size_t half_length = data_length >> 1;
+  const int16_t* second_in = data_in[bands - 1];
+  // The coefficients sit in the low half of each lane, and the high half is
+  // zero, so that _mm_madd_epi16() multiplies them by a sign extended sample.
+  const __m128i coefficients =
+      _mm_set_epi32(kAllPassCoefsQ15[1], kAllPassCoefsQ15[0],
+                    kAllPassCoefsQ15[1], kAllPassCoefsQ15[0]);
+  __m128i state32 = _mm_set_epi32(
+      lower_state[bands - 1] * (1 << 16), upper_state[bands - 1] * (1 << 16),
+      lower_state[0] * (1 << 16), upper_state[0] * (1 << 16));  // Q15
+  int32_t states[4];
+
+  for (i = 0; i < half_length; i++) {
+    __m128i in16 = _mm_unpacklo_epi32(LoadPair(&data_in[0][2 * i]),
+                                      LoadPair(&second_in[2 * i]));
+    __m128i in32 = _mm_srai_epi32(_mm_unpacklo_epi16(in16, in16), 16);
+    __m128i tmp32 = _mm_add_epi32(state32, _mm_madd_epi16(in32, coefficients));
+    __m128i out32 = _mm_srai_epi32(tmp32, 16);  // Q(-1)
+    __m128i out16, swapped, bands16;
+    int32_t first, second;
+
+    state32 = _mm_sub_epi32(_mm_slli_epi32(in32, 14),
+                            _mm_madd_epi16(out32, coefficients));  // Q14
+    state32 = _mm_slli_epi32(state32, 1);  // Q15.
+
+    // Make LP and HP signals, wrapping around like the scalar version.
+    out16 = _mm_packs_epi32(out32, out32);
+    swapped = _mm_shufflelo_epi16(out16, _MM_SHUFFLE(2, 3, 0, 1));
+    bands16 = _mm_unpacklo_epi16(_mm_sub_epi16(out16, swapped),
+                                 _mm_add_epi16(out16, swapped));
+    first = _mm_cvtsi128_si32(bands16);
+    hp_data_out[0][i] = (int16_t)first;
+    lp_data_out[0][i] = (int16_t)(first >> 16);
+    if (bands > 1) {
+      second = _mm_cvtsi128_si32(_mm_srli_si128(bands16, 8));
+      hp_data_out[1][i] = (int16_t)second;
+      lp_data_out[1][i] = (int16_t)(second >> 16);
+    }
+  }
+
+  _mm_storeu_si128((__m128i*)states, _mm_srai_epi32(state32, 16));  // Q(-1)
+  upper_state[0] = (int16_t)states[0];
+  lower_state[0] = (int16_t)states[1];
+  upper_state[bands - 1] = (int16_t)states[2 * (bands - 1)];
+  lower_state[bands - 1] = (int16_t)states[2 * (bands - 1) + 1];
+}
+
+// Same as WebRtcSpl_Energy(), including how it ignores -32768 when choosing
+// the scaling.
+static int32_t EnergySse2(const int16_t* data_in, size_t data_length,
+                          int* scale_factor) {
+  size_t i = 0;
+  int16_t maximums[8];
+  int16_t smax = -1;
+  int scaling = 0;
+  int32_t sums[4];
+  int32_t energy;
+  __m128i maximum = _mm_set1_epi16(-1);
+  __m128i sum = _mm_setzero_si128();
+  __m128i shift;
+
+  for (; i + 8 <= data_length; i += 8) {
+    __m128i values = _mm_loadu_si128((const __m128i*)&data_in[i]);
+    __m128i negated = _mm_sub_epi16(_mm_setzero_si128(), values);
+    maximum = _mm_max_epi16(maximum, _mm_max_epi16(values, negated));
+  }
+
+  _mm_storeu_si128((__m128i*)maximums, maximum);
+  for (i = 0; i < 8; i++) {
+    smax = WEBRTC_SPL_MAX(smax, maximums[i]);
+  }
+  for (i = data_length & ~(size_t)7; i < data_length; i++) {
+    int16_t sabs = (int16_t)(data_in[i] > 0 ? data_in[i] : -data_in[i]);
+    smax = WEBRTC_SPL_MAX(smax, sabs);
+  }
+
+  if (smax != 0) {
+    int16_t nbits = WebRtcSpl_GetSizeInBits((uint32_t)data_length);
+    int16_t t = WebRtcSpl_NormW32(WEBRTC_SPL_MUL(smax, smax));
+    scaling = (t > nbits) ? 0 : nbits - t;
+  }
+
+  shift = _mm_cvtsi32_si128(scaling);
+  for (i = 0; i + 8 <= data_length; i += 8) {
+    __m128i values = _mm_loadu_si128((const __m128i*)&data_in[i]);
+    __m128i low = _mm_mullo_epi16(values, values);
+    __m128i high = _mm_mulhi_epi16(values, values);
+    sum = _mm_add_epi32(sum, _mm_sra_epi32(_mm_unpacklo_epi16(low, high),
+                                           shift));
+    sum = _mm_add_epi32(sum, _mm_sra_epi32(_mm_unpackhi_epi16(low, high),
+                                           shift));
+  }
+
+  _mm_storeu_si128((__m128i*)sums, sum);
+  energy = sums[0] + sums[1] + sums[2] + sums[3];
+  for (; i < data_length; i++) {
+    energy += (data_in[i] * data_in[i]) >> scaling;
+  }
+
+  *scale_factor = scaling;
+  return energy;
+}
+
+// Same as LogOfEnergy(), using EnergySse2().
+static void LogOfEnergySse2(const int16_t* data_in, size_t data_length,
+                            int16_t offset, int16_t* total_energy,
+                            int16_t* log_energy) {
+  int tot_rshifts = 0;
+  uint32_t energy = 0;
+
+  RTC_DCHECK(data_in);
+  RTC_DCHECK_GT(data_length, 0);
+
+  energy = (uint32_t)EnergySse2(data_in, data_length, &tot_rshifts);
+  LogOfScaledEnergy(energy, tot_rshifts, offset, total_energy, log_energy);
+}
+
+// Same as WebRtcVad_CalculateFeaturesC(), with the two bands of the second
+// split filtered together, and the energies computed by EnergySse2().
+static int16_t CalculateFeaturesSse2(VadInstT* self, const int16_t* data_in,
+                                     size_t data_length, int16_t* features) {
+  int16_t total_energy = 0;
+  int16_t hp_120[120], lp_120[120];
+  int16_t hp_60[60], lp_60[60];
+  int16_t hp_lower_60[60], lp_lower_60[60];
+  int16_t hp_30[30], lp_30[30];
+  const int16_t* in_ptrs[2];
+  int16_t* hp_out_ptrs[2];
+  int16_t* lp_out_ptrs[2];
+  size_t length = data_length >> 1;
+
+  RTC_DCHECK_LE(data_length, 240);
+
+  // Split at 2000 Hz and downsample.
+  in_ptrs[0] = data_in;
+  hp_out_ptrs[0] = hp_120;
+  lp_out_ptrs[0] = lp_120;
+  SplitFiltersSse2(in_ptrs, data_length, 1, &self->upper_state[0],
+                   &self->lower_state[0], hp_out_ptrs, lp_out_ptrs);
+
+  // Split the upper band at 3000 Hz and the lower band at 1000 Hz.
+  in_ptrs[0] = hp_120;
+  in_ptrs[1] = lp_120;
+  hp_out_ptrs[0] = hp_60;  // [3000 - 4000] Hz.
+  lp_out_ptrs[0] = lp_60;  // [2000 - 3000] Hz.
+  hp_out_ptrs[1] = hp_lower_60;  // [1000 - 2000] Hz.
+  lp_out_ptrs[1] = lp_lower_60;  // [0 - 1000] Hz.
+  SplitFiltersSse2(in_ptrs, length, 2, &self->upper_state[1],
+                   &self->lower_state[1], hp_out_ptrs, lp_out_ptrs);
+
+  length >>= 1;
+  LogOfEnergySse2(hp_60, length, kOffsetVector[5], &total_energy,
+                  &features[5]);
+  LogOfEnergySse2(lp_60, length, kOffsetVector[4], &total_energy,
+                  &features[4]);
+  LogOfEnergySse2(hp_lower_60, length, kOffsetVector[3], &total_energy,
+                  &features[3]);
+
+  // Split at 500 Hz.
+  in_ptrs[0] = lp_lower_60;
+  hp_out_ptrs[0] = hp_30;  // [500 - 1000] Hz.
+  lp_out_ptrs[0] = lp_30;  // [0 - 500] Hz.
+  SplitFiltersSse2(in_ptrs, length, 1, &self->upper_state[3],
+                   &self->lower_state[3], hp_out_ptrs, lp_out_ptrs);
+
+  length >>= 1;
+  LogOfEnergySse2(hp_30, length, kOffsetVector[2], &total_energy,
+                  &features[2]);
+
+  // Split at 250 Hz.
+  in_ptrs[0] = lp_30;
+  hp_out_ptrs[0] = hp_60;  // [250 - 500] Hz.
+  lp_out_ptrs[0] = lp_60;  // [0 - 250] Hz.
+  SplitFiltersSse2(in_ptrs, length, 1, &self->upper_state[4],
+                   &self->lower_state[4], hp_out_ptrs, lp_out_ptrs);
+
+  length >>= 1;
+  LogOfEnergySse2(hp_60, length, kOffsetVector[1], &total_energy,
+                  &features[1]);
+
+  // Remove 0 Hz - 80 Hz, by high pass filtering the lower band.
+  HighPassFilter(lp_60, length, self->hp_filter_state, hp_120);
+  LogOfEnergySse2(hp_120, length, kOffsetVector[0], &total_energy,
+                  &features[0]);
+
+  return total_energy;
+}
+
+#endif  // WEBRTC_VAD_FILTERBANK_SSE2
+
+int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
+                                    size_t data_length, int16_t* features) {
+#if defined(WEBRTC_VAD_FILTERBANK_SSE2)
+  return CalculateFeaturesSse2(self, data_in, data_length, features);
+#else
+  return WebRtcVad_CalculateFeaturesC(self, data_in, data_length, features);
+#endif
+}
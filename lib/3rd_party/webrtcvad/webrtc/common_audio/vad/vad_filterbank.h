@@ -42,4 +42,11 @@ int16_t WebRtcVad_CalculateFeatures(VadInstT* self,
                                     size_t data_length,
                                     int16_t* features);
 
+// The portable version of WebRtcVad_CalculateFeatures(), which the vectorized
+// version matches exactly.
+int16_t WebRtcVad_CalculateFeaturesC(VadInstT* self,
+                                     const int16_t* data_in,
+                                     size_t data_length,
+                                     int16_t* features);
+
 #endif  // COMMON_AUDIO_VAD_VAD_FILTERBANK_H_
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2011 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Parts of this file derived from Chromium's base/cpu.cc.
+
+#include "webrtc/rtc_base/system/arch.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+#if defined(WEBRTC_ARCH_X86_FAMILY) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(WEBRTC_ARCH_X86_FAMILY) && !defined(_MSC_VER)
+// Intrinsic for "cpuid".
+#if defined(__pic__) && defined(__i386__)
+static inline void __cpuid(int cpu_info[4], int info_type) {
+  __asm__ volatile(
+      "mov %%ebx, %%edi\n"
+      "cpuid\n"
+      "xchg %%edi, %%ebx\n"
+      : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]),
+        "=d"(cpu_info[3])
+      : "a"(info_type), "c"(0));
+}
+#else
+static inline void __cpuid(int cpu_info[4], int info_type) {
+  __asm__ volatile("cpuid\n"
+                   : "=a"(cpu_info[0]), "=b"(cpu_info[1]), "=c"(cpu_info[2]),
+                     "=d"(cpu_info[3])
+                   : "a"(info_type), "c"(0));
+}
+#endif
+
+// Intrinsic for "xgetbv", which isn't available without -mxsave.
+static inline uint64_t _xgetbv(uint32_t xcr) {
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(xcr));
+  return ((uint64_t)edx << 32) | eax;
+}
+#endif  // WEBRTC_ARCH_X86_FAMILY && !_MSC_VER
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// Actual feature detection for x86. Leaf 7 must be queried with a sub-leaf of
+// 0, which the versions of __cpuid above pass in ecx.
+static int CpuInfo(CPUFeature feature) {
+  int cpu_info[4];
+  __cpuid(cpu_info, 0);
+  int max_leaf = cpu_info[0];
+  __cpuid(cpu_info, 1);
+  if (feature == kSSE2) {
+    return 0 != (cpu_info[3] & 0x04000000);
+  }
+  if (feature == kSSE3) {
+    return 0 != (cpu_info[2] & 0x00000001);
+  }
+  if (feature == kSSE4_1) {
+    return 0 != (cpu_info[2] & 0x00080000);
+  }
+  if (feature == kAVX2) {
+    // AVX2 also needs the OS to save the upper halves of the ymm registers.
+    int has_osxsave = 0 != (cpu_info[2] & 0x08000000);
+    int has_avx = 0 != (cpu_info[2] & 0x10000000);
+    if (max_leaf < 7 || !has_osxsave || !has_avx ||
+        (_xgetbv(0) & 0x6) != 0x6) {
+      return 0;
+    }
+
+#if defined(_MSC_VER)
+    __cpuidex(cpu_info, 7, 0);
+#else
+    __cpuid(cpu_info, 7);
+#endif
+    return 0 != (cpu_info[1] & 0x00000020);
+  }
+  return 0;
+}
+#else
+// Default to straight C for other platforms.
+static int CpuInfo(CPUFeature feature) {
+  (void)feature;
+  return 0;
+}
+#endif
+
+static int CpuInfoNoASM(CPUFeature feature) {
+  (void)feature;
+  return 0;
+}
+
+WebRtc_CPUInfo WebRtc_GetCPUInfo = CpuInfo;
+WebRtc_CPUInfo WebRtc_GetCPUInfoNoASM = CpuInfoNoASM;
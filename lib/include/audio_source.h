@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frame_ring.h"
+
+namespace speechrecorder {
+
+// where a processor's audio comes from. between Start() and Stop(), a source
+// writes audio at the processor's sampleRate into the processor's ring.
+class AudioSource {
+ public:
+  virtual ~AudioSource() {}
+  virtual void Start(FrameRing* ring) = 0;
+  virtual void Stop() = 0;
+};
+
+// audio handed over from memory by whichever thread calls Push(). pushes
+// from several threads are serialized, and Stop() waits for a push that's
+// already running. audio that's pushed while the source is stopped is
+// dropped.
+class MemorySource : public AudioSource {
+ private:
+  FrameRing* ring_ = nullptr;
+  std::mutex mutex_;
+
+ public:
+  void Start(FrameRing* ring) override;
+  void Stop() override;
+  void Push(const short* samples, size_t size);
+};
+
+// audio from a generator, paced on its own thread at the rate it would be
+// captured, so processors can be exercised without an audio device. generate
+// fills one frame at a time.
+class SyntheticSource : public AudioSource {
+ private:
+  std::function<void(short*, size_t)> generate_;
+  std::vector<short> frame_;
+  int sampleRate_;
+  std::atomic<bool> stopped_;
+  std::thread thread_;
+
+ public:
+  SyntheticSource(int samplesPerFrame, int sampleRate,
+                  std::function<void(short*, size_t)> generate);
+  ~SyntheticSource();
+  void Start(FrameRing* ring) override;
+  void Stop() override;
+};
+
+}  // namespace speechrecorder
@@ -1,33 +1,54 @@
 #pragma once
 
-#include <readerwriterqueue.h>
-
 #include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "aligned.h"
-#include "microphone.h"
+#include "audio_source.h"
+#include "frame_ring.h"
+#include "frame_statistics.h"
 #include "onnxruntime_cxx_api.h"
+#include "ring_buffer.h"
+#include "silero_vad.h"
+#include "silero_vad_scheduler.h"
+#include "span.h"
 #include "webrtcvad.h"
 
 namespace speechrecorder {
 
 struct ChunkProcessorOptions {
+  // how many frames from the source can wait to be processed, and what to do
+  // with new frames when that many are waiting.
+  int captureBufferFrames = 10;
+  OverflowPolicy captureOverflow = OverflowPolicy::DropOldest;
+  // the rate the microphone captures at, which is resampled to sampleRate. 0
+  // captures at sampleRate.
+  int captureSampleRate = 0;
   int consecutiveFramesForSilence = 5;
   int consecutiveFramesForSpeaking = 1;
   int device = -1;
   int leadingBufferFrames = 10;
   std::function<void(std::vector<short>)> onChunkStart = nullptr;
+  // allocation-free alternatives to onChunkStart and onAudio. the audio view
+  // points into the processor's buffers and is only valid during the call.
+  std::function<void(Span<const short>)> onChunkStartView = nullptr;
   std::function<void(std::vector<short>, bool, double, bool, double, int)>
       onAudio = nullptr;
+  std::function<void(Span<const short>, bool, double, bool, double, int)>
+      onAudioView = nullptr;
   std::function<void()> onChunkEnd = nullptr;
   int samplesPerFrame = 480;
   int sampleRate = 16000;
+  int sileroVadBatchSize = 32;
+  int sileroVadBatchWindow = 0;
   int sileroVadBufferSize = 2000;
   int sileroVadRateLimit = 3;
+  int sileroVadSessions = 1;
   double sileroVadSilenceThreshold = 0.1;
   double sileroVadSpeakingThreshold = 0.3;
   int webrtcVadLevel = 3;
@@ -37,30 +58,57 @@ struct ChunkProcessorOptions {
 
 class ChunkProcessor {
  private:
-  std::vector<short> leadingBuffer_;
+  std::string modelPath_;
+  RingBuffer<short> leadingBuffer_;
   int consecutiveSilence_ = 0;
   int consecutiveSpeaking_ = 0;
   int framesUntilSileroVad_ = 0;
-  Microphone microphone_;
-  BlockingReaderWriterQueue<short*> queue_;
-  std::vector<float> sileroBuffer_;
+  FrameStatistics frameStatistics_;
+  FrameRing ring_;
+  std::unique_ptr<AudioSource> source_;
+  RingBuffer<float> sileroBuffer_;
+  std::vector<float> sileroFrame_;
+  std::unique_ptr<SileroVad> sileroVad_;
   double sileroVadProbability_ = 0.0;
   bool speaking_ = false;
   std::atomic<bool> stopped_;
+  // the queue thread sleeps on queueResumed_ while the source is stopped,
+  // and only polls the ring while it's running.
+  std::mutex queueLock_;
+  std::condition_variable queueResumed_;
+  bool destroying_ = false;
   std::mutex toggleLock_;
   std::thread startThread_;
   std::thread stopThread_;
   std::thread queueThread_;
   WebrtcVad webrtcVad_;
-  std::vector<short> webrtcVadBuffer_;
-  std::vector<bool> webrtcVadResults_;
+  std::vector<short> webrtcVadRemainder_;
+  size_t webrtcVadRemainderSize_ = 0;
+  RingBuffer<bool> webrtcVadResults_;
+
+  void ProcessWebrtcVad(const short* input);
+  void ResetSileroVad();
 
  public:
   ChunkProcessorOptions options_;
-  ChunkProcessor(std::string modelPath, ChunkProcessorOptions options);
+
+  // between Start() and Stop(), frames from source are processed on a thread
+  // of the processor's own. without a source, the processor is headless, and
+  // only processes the frames passed to Process().
+  ChunkProcessor(std::string modelPath, ChunkProcessorOptions options,
+                 std::unique_ptr<AudioSource> source = nullptr);
   ~ChunkProcessor();
-  void Process(short* audio);
+  void Process(const short* audio);
   void Reset();
+
+  // counters for the ring that frames from the source wait in.
+  FrameRingStats CaptureStats() const { return ring_.Stats(); }
+
+  // the sum of squares, peak, and zero crossings of the last frame.
+  const FrameStatistics& LastFrameStatistics() const {
+    return frameStatistics_;
+  }
+
   void Start();
   void Stop();
 
@@ -0,0 +1,12 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define SPEECHRECORDER_X86
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define SPEECHRECORDER_NEON
+#endif
+
+// the webrtc signal processing library detects the cpu features for its own
+// kernels, so the rest of the library asks it too.
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <portaudio.h>
+
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace speechrecorder {
 
@@ -29,4 +33,11 @@ struct Device {
 
 std::vector<Device> GetDevices();
 
+// portaudio is shared by every device in the process, and isn't thread safe,
+// so it's only called with this lock held. the first AcquirePortAudio()
+// initializes it, and the matching last ReleasePortAudio() terminates it.
+std::mutex& PortAudioMutex();
+PaError AcquirePortAudio();
+void ReleasePortAudio();
+
 }  // namespace speechrecorder
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace speechrecorder {
+
+// what a frame ring does with a new frame when the processor has fallen so
+// far behind that every slot is still in use.
+enum class OverflowPolicy {
+  // replace the oldest frame that the processor hasn't started on.
+  DropOldest,
+  // discard the new frame.
+  DropNewest,
+  // double the number of slots. this allocates on the source's thread, so
+  // unlike the drop policies it isn't safe in an audio callback.
+  Grow,
+};
+
+struct FrameRingStats {
+  // frames written by the source, including any that were dropped.
+  uint64_t frames = 0;
+  // frames dropped because the ring was full, plus any audio the source
+  // itself lost, like a device reporting that its input overflowed.
+  uint64_t overruns = 0;
+  // times the source couldn't deliver audio in time, like a device reporting
+  // that its input underflowed.
+  uint64_t underruns = 0;
+  // frames waiting for the processor.
+  uint64_t depth = 0;
+  size_t capacity = 0;
+};
+
+// a single-producer, single-consumer queue of frames, shared by a source and
+// the processor. a source writes audio of any length, which is copied into
+// the next free slot, and each slot is handed to the processor once it's a
+// full frame. the processor holds on to one frame at a time, until
+// Release(), so slots are never overwritten while they're being processed.
+// writes never allocate (unless the ring grows), block, loop, or make system
+// calls, so they're safe in an audio callback, and reads only retry when a
+// frame is dropped out from under them.
+class FrameRing {
+ private:
+  struct Generation {
+    std::unique_ptr<short[]> samples;
+    uint64_t frames;
+    // the first frame written into this generation's slots.
+    uint64_t start;
+  };
+
+  static constexpr int maxGenerations_ = 16;
+  static constexpr uint64_t none_ = UINT64_MAX;
+
+  size_t samplesPerFrame_;
+  OverflowPolicy policy_;
+  std::unique_ptr<Generation> generations_[maxGenerations_];
+  std::atomic<int> generationCount_;
+  std::chrono::microseconds pollInterval_;
+  std::atomic<bool> interrupted_;
+
+  // frames are numbered in the order they're written. every frame before
+  // read_ has been taken by the processor or dropped, and reading_ is the
+  // frame the processor is working on.
+  std::atomic<uint64_t> write_;
+  std::atomic<uint64_t> read_;
+  std::atomic<uint64_t> reading_;
+  std::atomic<uint64_t> overruns_;
+  std::atomic<uint64_t> underruns_;
+  std::atomic<uint64_t> frames_;
+
+  // only used by the source.
+  short* frame_ = nullptr;
+  size_t filled_ = 0;
+
+  short* Acquire();
+  short* Slot(uint64_t frame) const;
+
+ public:
+  FrameRing(size_t samplesPerFrame, size_t frames,
+            OverflowPolicy policy = OverflowPolicy::DropOldest,
+            std::chrono::microseconds pollInterval =
+                std::chrono::milliseconds(1));
+  FrameRing(const FrameRing&) = delete;
+  FrameRing& operator=(const FrameRing&) = delete;
+
+  // called by the source.
+  void Write(const short* samples, size_t size);
+  void CountOverrun() { overruns_.fetch_add(1, std::memory_order_relaxed); }
+  void CountUnderrun() { underruns_.fetch_add(1, std::memory_order_relaxed); }
+
+  // called by the processor. Read() returns the oldest waiting frame, or
+  // null if there isn't one, and Wait() checks every pollInterval until
+  // there is, or returns null once Interrupt() is called, until Resume() is
+  // called. a frame stays valid until Release().
+  const short* Read();
+  const short* Wait();
+  void Release() { reading_.store(none_); }
+  void Interrupt();
+  void Resume();
+
+  // drops every waiting frame, as well as a partially written one. the
+  // source must be stopped.
+  void Clear();
+
+  FrameRingStats Stats() const;
+};
+
+}  // namespace speechrecorder
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace speechrecorder {
+
+struct FrameStatistics {
+  uint64_t sumOfSquares = 0;
+  int peak = 0;
+  int zeroCrossings = 0;
+};
+
+// converts a frame of audio to floats in [-1, 1] and measures it in a single
+// pass. the fastest implementation the cpu supports (avx2, sse2, or neon) is
+// picked the first time this is called.
+FrameStatistics AnalyzeFrame(const short* input, float* output, size_t size);
+
+// the portable implementation, which the vectorized ones match exactly.
+FrameStatistics AnalyzeFrameScalar(const short* input, float* output,
+                                   size_t size);
+
+}  // namespace speechrecorder
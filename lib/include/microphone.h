@@ -1,40 +1,51 @@
 #pragma once
 
 #include <portaudio.h>
-#include <readerwriterqueue.h>
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "audio_source.h"
+#include "resampler.h"
 #include "webrtcvad.h"
 
-using namespace moodycamel;
-
 namespace speechrecorder {
 
 struct MicrophoneCallbackData {
-  std::vector<short>* buffer;
-  int bufferIndex = 0;
-  BlockingReaderWriterQueue<short*>* queue;
+  FrameRing* ring = nullptr;
+  Resampler* resampler = nullptr;
+  std::vector<short>* resampled = nullptr;
 };
 
-class Microphone {
+// the portaudio callback, which runs on a real-time thread. it never
+// allocates, locks, or makes system calls, so it's safe to run at any
+// priority.
+int callback(const void* input, void* output, unsigned long samplesPerFrame,
+             const PaStreamCallbackTimeInfo* timeInfo,
+             PaStreamCallbackFlags statusFlags, void* callbackData);
+
+class Microphone : public AudioSource {
  private:
-  std::vector<short> buffer_;
   MicrophoneCallbackData callbackData_;
   int device_;
   int samplesPerFrame_;
   int sampleRate_;
-  PaStream* stream_;
+  int captureSampleRate_;
+  std::unique_ptr<Resampler> resampler_;
+  std::vector<short> resampled_;
+  PaStream* stream_ = nullptr;
+  bool initialized_ = false;
 
   void HandleError(PaError error, const std::string& message);
 
  public:
   Microphone(int device, int samplesPerFrame, int sampleRate,
-             BlockingReaderWriterQueue<short*>* queue);
-  void Start();
-  void Stop();
+             int captureSampleRate);
+  ~Microphone();
+  void Start(FrameRing* ring) override;
+  void Stop() override;
 };
 
 }  // namespace speechrecorder
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <readerwriterqueue.h>
+
+namespace speechrecorder {
+
+// free list of reusable objects. objects are created on demand and recycled
+// rather than deleted, so steady-state use never touches the heap. the free
+// list is a single-producer single-consumer queue: Acquire must only be
+// called from one thread and Release from one (possibly different) thread.
+template <typename T>
+class Pool {
+ private:
+  moodycamel::ReaderWriterQueue<T*> free_;
+
+ public:
+  explicit Pool(size_t capacity = 64) : free_(capacity) {
+    for (size_t i = 0; i < capacity; i++) {
+      free_.enqueue(new T());
+    }
+  }
+
+  ~Pool() {
+    T* e;
+    while (free_.try_dequeue(e)) {
+      delete e;
+    }
+  }
+
+  Pool(const Pool&) = delete;
+  Pool& operator=(const Pool&) = delete;
+
+  T* Acquire() {
+    T* e;
+    if (free_.try_dequeue(e)) {
+      return e;
+    }
+
+    return new T();
+  }
+
+  void Release(T* e) { free_.enqueue(e); }
+};
+
+}  // namespace speechrecorder
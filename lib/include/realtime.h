@@ -0,0 +1,22 @@
+#pragma once
+
+namespace speechrecorder {
+
+// marks the current thread as running real-time audio code for as long as
+// the scope lasts, like an audio callback, which mustn't allocate, lock, or
+// make system calls. when built with SPEECHRECORDER_REALTIME_CHECKS, any
+// allocation inside a scope aborts, so that anything that creeps onto the
+// audio path fails in testing instead of causing the odd dropout.
+class RealtimeScope {
+ public:
+#ifdef SPEECHRECORDER_REALTIME_CHECKS
+  RealtimeScope();
+  ~RealtimeScope();
+#else
+  RealtimeScope() {}
+#endif
+  RealtimeScope(const RealtimeScope&) = delete;
+  RealtimeScope& operator=(const RealtimeScope&) = delete;
+};
+
+}  // namespace speechrecorder
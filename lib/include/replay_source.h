@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "audio_source.h"
+
+namespace speechrecorder {
+
+// replays a wav file, or raw 16-bit mono pcm from a file or a pipe, paced at
+// the rate it would have been captured, or `speed` times faster. audio that
+// isn't at sampleRate is resampled, and raw audio is at rawSampleRate. pipes
+// are read as they're written to, and each Start() replays from the
+// beginning of the file. the last frame is padded with silence, and nothing
+// is queued after it.
+class ReplaySource : public AudioSource {
+ private:
+  std::string path_;
+  int samplesPerFrame_;
+  int sampleRate_;
+  int rawSampleRate_;
+  double speed_;
+  std::atomic<bool> stopped_;
+  std::thread thread_;
+
+  void Replay(FrameRing* ring);
+
+ public:
+  ReplaySource(const std::string& path, int samplesPerFrame, int sampleRate,
+               int rawSampleRate, double speed);
+  ~ReplaySource();
+  void Start(FrameRing* ring) override;
+  void Stop() override;
+};
+
+}  // namespace speechrecorder
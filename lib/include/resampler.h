@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
+
+namespace speechrecorder {
+
+// converts interleaved audio at any rate and channel count to mono audio at
+// the rate the processor expects. channels are averaged, 48 kHz audio is
+// resampled with webrtc's fixed-point kernels, and any other rate uses a
+// windowed-sinc filter. state is kept between calls, so a stream can be
+// passed in pieces of any size.
+class Resampler {
+ private:
+  int inputRate_;
+  int outputRate_;
+  int channels_;
+  std::vector<short> mono_;
+  std::vector<short> pending_;
+  std::vector<int32_t> scratch_;
+  WebRtcSpl_State48khzTo16khz state16_;
+  WebRtcSpl_State48khzTo8khz state8_;
+  std::vector<float> history_;
+  std::vector<float> filters_;
+  double position_ = 0.0;
+  double step_;
+
+  void ProcessBlocks(const short* input, size_t size,
+                     std::vector<short>& output);
+  void ProcessSinc(const short* input, size_t size,
+                   std::vector<short>& output);
+
+ public:
+  Resampler(int inputRate, int outputRate, int channels = 1);
+
+  int InputRate() const { return inputRate_; }
+  int OutputRate() const { return outputRate_; }
+  int Channels() const { return channels_; }
+
+  // true if audio is passed through unchanged.
+  bool Passthrough() const {
+    return inputRate_ == outputRate_ && channels_ == 1;
+  }
+
+  // appends the result of resampling `frames` frames of interleaved input to
+  // `output`. a few samples of latency are held back between calls. this can
+  // allocate, unless Reserve() was called with at least `frames`.
+  void Process(const short* input, size_t frames, std::vector<short>& output);
+  void Reset();
+
+  // reserves enough memory that calls with up to `frames` frames of input
+  // never allocate, as long as the output has room too.
+  void Reserve(size_t frames);
+};
+
+}  // namespace speechrecorder
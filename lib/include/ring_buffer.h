@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace speechrecorder {
+
+// fixed-capacity FIFO of the most recent elements pushed into it. storage is
+// allocated once, aligned to a cache line, and every element is written
+// twice (at its slot and at slot + capacity), so the live contents are always
+// available as a single contiguous range without ever moving memory.
+template <typename T>
+class RingBuffer {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "RingBuffer elements must be trivially copyable");
+
+ private:
+  static constexpr size_t alignment_ = 64;
+
+  T* storage_ = nullptr;
+  size_t capacity_ = 0;
+  size_t head_ = 0;
+  size_t size_ = 0;
+
+  void Write(const T* values, size_t count) {
+    // copy into the primary slots and their mirrors, splitting at wraparound.
+    size_t first = std::min(count, capacity_ - head_);
+    std::memcpy(storage_ + head_, values, first * sizeof(T));
+    std::memcpy(storage_ + head_ + capacity_, values, first * sizeof(T));
+    if (count > first) {
+      std::memcpy(storage_, values + first, (count - first) * sizeof(T));
+      std::memcpy(storage_ + capacity_, values + first,
+                  (count - first) * sizeof(T));
+    }
+
+    head_ += count;
+    if (head_ >= capacity_) {
+      head_ -= capacity_;
+    }
+  }
+
+ public:
+  explicit RingBuffer(size_t capacity) : capacity_(capacity) {
+    if (capacity_ > 0) {
+      storage_ = static_cast<T*>(::operator new(
+          capacity_ * 2 * sizeof(T), std::align_val_t(alignment_)));
+      std::fill(storage_, storage_ + capacity_ * 2, T());
+    }
+  }
+
+  ~RingBuffer() {
+    if (storage_ != nullptr) {
+      ::operator delete(storage_, std::align_val_t(alignment_));
+    }
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  // contiguous view of the contents, oldest element first.
+  T* Data() {
+    return storage_ + (head_ + capacity_ - size_);
+  }
+
+  const T* Data() const {
+    return storage_ + (head_ + capacity_ - size_);
+  }
+
+  T* begin() { return Data(); }
+  T* end() { return Data() + size_; }
+  const T* begin() const { return Data(); }
+  const T* end() const { return Data() + size_; }
+
+  size_t Capacity() const { return capacity_; }
+  size_t Size() const { return size_; }
+  bool Empty() const { return size_ == 0; }
+  bool Full() const { return size_ == capacity_; }
+
+  void Clear() { size_ = 0; }
+
+  // remove count elements from the front (oldest end) of the buffer.
+  void Discard(size_t count) { size_ -= std::min(count, size_); }
+
+  void Push(T value) { Push(&value, 1); }
+
+  // append values, evicting the oldest elements once the buffer is full.
+  void Push(const T* values, size_t count) {
+    if (count > capacity_) {
+      values += count - capacity_;
+      count = capacity_;
+    }
+
+    Write(values, count);
+    size_ = std::min(size_ + count, capacity_);
+  }
+};
+
+}  // namespace speechrecorder
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "onnxruntime_cxx_api.h"
+
+namespace speechrecorder {
+
+// v3 models take a window of audio and return [silence, speech]
+// probabilities. v4 models are stateful, carrying an LSTM's h and c tensors
+// between calls, and v5 models merge those into a single state tensor and
+// expect each hop to be prefixed with the tail of the previous one.
+enum class SileroVadVersion { V3, V4, V5 };
+
+// sessions come from a process-wide pool of up to `sessions` sessions per
+// model, so processors can run inference concurrently. preloading fills the
+// pool ahead of time without handing anything out, and each SileroVad
+// acquires its session exactly once, which advances the round robin.
+void PreloadSileroVadSession(const std::string& modelPath, int sessions = 1);
+Ort::Session& AcquireSileroVadSession(const std::string& modelPath,
+                                      int sessions = 1);
+
+class SileroVadScheduler;
+
+// runs a silero model on one input at a time. all tensors are allocated and
+// bound to the session once, so Process doesn't allocate.
+class SileroVad {
+ private:
+  Ort::Session& session_;
+  Ort::MemoryInfo memory_;
+  Ort::RunOptions runOptions_;
+  SileroVadVersion version_;
+  int contextSize_;
+  int hopSize_;
+  size_t inputSize_;
+  std::vector<float> input_;
+  int64_t sampleRate_;
+  std::vector<float> output_;
+  std::vector<float> state_;
+  std::vector<float> stateOutput_;
+  std::vector<Ort::Value> tensors_;
+  Ort::IoBinding binding_;
+  SileroVadScheduler* scheduler_ = nullptr;
+
+  void Bind(const char* name, float* data, size_t size,
+            std::vector<int64_t> dimensions, bool input);
+
+ public:
+  SileroVad(Ort::Session& session, int sampleRate, size_t windowSize);
+  SileroVad(const SileroVad&) = delete;
+  SileroVad& operator=(const SileroVad&) = delete;
+
+  // samples from the previous hop that prefix each input.
+  int ContextSize() const { return contextSize_; }
+
+  // new samples consumed by each call to a stateful model.
+  int HopSize() const { return hopSize_; }
+
+  // samples passed to each call to Process.
+  size_t InputSize() const { return inputSize_; }
+
+  int SampleRate() const { return (int)sampleRate_; }
+
+  SileroVadVersion Version() const { return version_; }
+
+  // run inference as part of a batch shared with other processors, rather
+  // than on this instance's own bindings.
+  void SetScheduler(SileroVadScheduler* scheduler) { scheduler_ = scheduler; }
+
+  // returns the probability of speech in InputSize() samples of audio.
+  double Process(const float* audio);
+  void Reset();
+};
+
+}  // namespace speechrecorder
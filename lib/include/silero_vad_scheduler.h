@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "onnxruntime_cxx_api.h"
+#include "silero_vad.h"
+
+namespace speechrecorder {
+
+// collects silero requests from many processors and runs them as a single
+// [B, N] batch. callers block in Process until their batch has run, which is
+// at most `window` after the first request in the batch arrives, or sooner
+// if the batch fills up.
+class SileroVadScheduler {
+ private:
+  struct Request {
+    const float* input;
+    float* state;
+    double result = 0.0;
+    bool done = false;
+  };
+
+  Ort::Session& session_;
+  Ort::MemoryInfo memory_;
+  Ort::RunOptions runOptions_;
+  SileroVadVersion version_;
+  size_t inputSize_;
+  int64_t sampleRate_;
+  std::chrono::milliseconds window_;
+  size_t batchSize_;
+  std::vector<float> input_;
+  std::vector<float> output_;
+  std::vector<float> state_;
+  std::vector<float> stateOutput_;
+  // every batch size has its own bindings, made once up front, so running a
+  // batch doesn't allocate. bindings_[b - 1] runs a batch of b requests.
+  std::vector<Ort::Value> tensors_;
+  std::vector<Ort::IoBinding> bindings_;
+  std::vector<Request*> batch_;
+  std::vector<Request*> pending_;
+  std::mutex mutex_;
+  std::condition_variable requested_;
+  std::condition_variable completed_;
+  bool stopped_ = false;
+  std::thread thread_;
+
+  void Bind(Ort::IoBinding& binding, const char* name, float* data,
+            size_t size, std::vector<int64_t> dimensions, bool input);
+  void Run();
+
+ public:
+  SileroVadScheduler(Ort::Session& session, const SileroVad& vad,
+                     int window, int batchSize);
+  ~SileroVadScheduler();
+
+  // returns the process-wide scheduler for the given model and settings.
+  static SileroVadScheduler& Get(const std::string& modelPath,
+                                 const SileroVad& vad, int window,
+                                 int batchSize, int sessions);
+
+  // runs the model on InputSize() samples of input as part of the next batch.
+  // for stateful models, state is read and then updated in place.
+  double Process(const float* input, float* state);
+};
+
+}  // namespace speechrecorder
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+namespace speechrecorder {
+
+// non-owning view over a contiguous range, a stand-in for std::span until the
+// library moves to c++20. views passed to callbacks are only valid for the
+// duration of the call.
+template <typename T>
+class Span {
+ private:
+  T* data_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  Span() = default;
+  Span(T* data, size_t size) : data_(data), size_(size) {}
+
+  T* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  T* begin() const { return data_; }
+  T* end() const { return data_ + size_; }
+  T& operator[](size_t i) const { return data_[i]; }
+};
+
+}  // namespace speechrecorder
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dr_wav.h"
+
+namespace speechrecorder {
+
+// reads a wav file as mono 16-bit samples, a block at a time. the file is
+// memory mapped rather than read up front, so memory use doesn't depend on
+// the length of the file. when the file is already mono 16-bit pcm, blocks
+// point straight into the mapping, and nothing is decoded or copied.
+class WavReader {
+ private:
+  const unsigned char* data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#endif
+  drwav wav_;
+  bool open_ = false;
+  bool direct_ = false;
+  uint64_t position_ = 0;
+  std::vector<short> frames_;
+  std::vector<short> buffer_;
+
+ public:
+  explicit WavReader(const std::string& path);
+  WavReader(const WavReader&) = delete;
+  WavReader& operator=(const WavReader&) = delete;
+  ~WavReader();
+
+  bool IsOpen() const { return open_; }
+  int Channels() const { return open_ ? wav_.channels : 0; }
+  int SampleRate() const { return open_ ? (int)wav_.sampleRate : 0; }
+
+  // the number of samples per channel in the file.
+  uint64_t Size() const { return open_ ? wav_.totalPCMFrameCount : 0; }
+
+  // the number of samples per channel that haven't been read yet.
+  uint64_t Remaining() const { return Size() - position_; }
+
+  // returns the next `size` samples, downmixed to mono, or null if fewer
+  // than `size` samples are left. the result is valid until the next call.
+  const short* Read(size_t size);
+};
+
+}  // namespace speechrecorder
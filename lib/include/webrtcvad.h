@@ -1,22 +1,68 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 extern "C" {
 #include "webrtc/common_audio/vad/include/webrtc_vad.h"
+#include "webrtc/common_audio/vad/vad_core.h"
 }
 
 namespace speechrecorder {
 
+// everything the webrtc vad remembers between frames. it's a plain struct, so
+// it can be copied without allocating.
+typedef VadInstT WebrtcVadState;
+
 class WebrtcVad {
  private:
-  VadInst* instance_ = nullptr;
+  WebrtcVadState state_;
   int level_;
   int sampleRate_;
 
  public:
   WebrtcVad(int level, int sampleRate);
-  ~WebrtcVad();
-  bool Process(int16_t* buffer, size_t size);
+  bool Process(const int16_t* buffer, size_t size);
   void Reset();
+
+  // copies the state out, or replaces it, so that a pooled processor can be
+  // put back into a known state. snapshots have to come from a vad with the
+  // same level.
+  void Snapshot(WebrtcVadState& snapshot) const;
+  void Restore(const WebrtcVadState& snapshot);
+};
+
+struct WebrtcVadLanes;
+
+// runs the webrtc vad on many streams in lockstep. streams are processed in
+// groups of kLanes, with the state of each group stored as one array per
+// field, so that each step of the vad is a simd instruction covering the whole
+// group. the decisions are exactly the same as running a WebrtcVad on each
+// stream.
+class WebrtcVadBank {
+ private:
+  std::vector<std::unique_ptr<WebrtcVadLanes>> groups_;
+  int streams_;
+  int level_;
+  int sampleRate_;
+
+ public:
+  static const int kLanes = 8;
+
+  WebrtcVadBank(int streams, int level, int sampleRate);
+  ~WebrtcVadBank();
+
+  // frames holds one pointer per stream, each to size samples, and results
+  // receives one decision per stream. every stream has to advance together.
+  void Process(const int16_t* const* frames, size_t size, bool* results);
+  void Reset();
+  int Streams() const { return streams_; }
+
+  // the same as WebrtcVad::Snapshot() and WebrtcVad::Restore() for a single
+  // stream, so that a stream can be handed to a new source without resetting
+  // the others. snapshots can be moved between a bank and a WebrtcVad.
+  void Snapshot(int stream, WebrtcVadState& snapshot) const;
+  void Restore(int stream, const WebrtcVadState& snapshot);
 };
 
 }  // namespace speechrecorder
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <chrono>
+
+#include "audio_source.h"
+
+namespace speechrecorder {
+
+void MemorySource::Start(FrameRing* ring) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ring_ = ring;
+}
+
+void MemorySource::Stop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ring_ = nullptr;
+}
+
+void MemorySource::Push(const short* samples, size_t size) {
+  // the ring only takes writes from one thread at a time.
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (ring_ != nullptr) {
+    ring_->Write(samples, size);
+  }
+}
+
+SyntheticSource::SyntheticSource(int samplesPerFrame, int sampleRate,
+                                 std::function<void(short*, size_t)> generate)
+    : generate_(generate),
+      frame_(samplesPerFrame),
+      sampleRate_(sampleRate),
+      stopped_(true) {}
+
+SyntheticSource::~SyntheticSource() { Stop(); }
+
+void SyntheticSource::Start(FrameRing* ring) {
+  Stop();
+  stopped_ = false;
+  thread_ = std::thread([this, ring] {
+    // frames are scheduled from the start time rather than from each other,
+    // so time spent generating doesn't accumulate as drift.
+    std::chrono::duration<double> period((double)frame_.size() / sampleRate_);
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 1; !stopped_; i++) {
+      generate_(frame_.data(), frame_.size());
+      ring->Write(frame_.data(), frame_.size());
+      std::this_thread::sleep_until(
+          start + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      period * (double)i));
+    }
+  });
+}
+
+void SyntheticSource::Stop() {
+  stopped_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+}  // namespace speechrecorder
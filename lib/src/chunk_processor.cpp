@@ -2,6 +2,7 @@
 #include <chrono>
 #include <climits>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 #include <memory>
 
@@ -9,119 +10,95 @@
 
 namespace speechrecorder {
 
-static std::mutex ortMutex_;
-static std::unique_ptr<Ort::Env> ortEnv_;
-static std::unique_ptr<Ort::MemoryInfo> ortMemory_;
-static std::unique_ptr<Ort::Session> ortSession_;
-
 ChunkProcessor::ChunkProcessor(std::string modelPath,
-                               ChunkProcessorOptions options)
+                               ChunkProcessorOptions options,
+                               std::unique_ptr<AudioSource> source)
     : options_(options),
-      queue_(),
-      stopped_(false),
-      microphone_(options.device, options.samplesPerFrame, options.sampleRate,
-                  &queue_),
-      webrtcVad_(options.webrtcVadLevel, options.sampleRate) {
+      modelPath_(modelPath),
+      leadingBuffer_(options.leadingBufferFrames * options.samplesPerFrame),
+      sileroBuffer_(std::max(options.sileroVadBufferSize,
+                             options.samplesPerFrame + 2 * 512)),
+      sileroFrame_(options.samplesPerFrame),
+      stopped_(true),
+      ring_(options.samplesPerFrame, options.captureBufferFrames,
+            options.captureOverflow,
+            std::chrono::microseconds(
+                std::max(1000000LL * options.samplesPerFrame /
+                             options.sampleRate / 4,
+                         1LL))),
+      source_(std::move(source)),
+      webrtcVad_(options.webrtcVadLevel, options.sampleRate),
+      webrtcVadRemainder_(options.webrtcVadBufferSize),
+      webrtcVadResults_(options.webrtcVadResultsSize) {
+  if (!source_) {
+    return;
+  }
+
   queueThread_ = std::thread([&, modelPath] {
-    ortMutex_.lock();
-    if (!ortSession_) {
-      ortEnv_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING,
-                                           "SpeechRecorder::ChunkProcessor");
-      ortMemory_ = std::make_unique<Ort::MemoryInfo>(Ort::MemoryInfo::CreateCpu(
-          OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault));
-
-      Ort::SessionOptions sessionOptions;
-      sessionOptions.SetIntraOpNumThreads(1);
-#ifdef _WIN32
-      std::wstring wstring(modelPath.begin(), modelPath.end());
-      ortSession_ = std::make_unique<Ort::Session>(*ortEnv_, wstring.c_str(),
-                                                   sessionOptions);
-
-#else
-      ortSession_ = std::make_unique<Ort::Session>(*ortEnv_, modelPath.c_str(),
-                                                   sessionOptions);
-#endif
-    }
-    ortMutex_.unlock();
+    // load the model ahead of the first frame.
+    PreloadSileroVadSession(modelPath, options_.sileroVadSessions);
     while (true) {
-      short* audio;
-      queue_.wait_dequeue(audio);
-      // null pointer means the destructor wants us to stop the thread.
+      {
+        std::unique_lock<std::mutex> lock(queueLock_);
+        queueResumed_.wait(lock, [&] { return destroying_ || !stopped_; });
+        if (destroying_) {
+          return;
+        }
+      }
+
+      // null pointer means the source was stopped, or the destructor wants
+      // us to stop the thread.
+      const short* audio = ring_.Wait();
       if (audio == nullptr) {
-        return;
+        continue;
       }
       if (!stopped_) {
         Process(audio);
       }
+
+      ring_.Release();
     }
   });
 }
 
 ChunkProcessor::~ChunkProcessor() {
-  // shutdown the queue thread.
-  stopped_ = true;
-  queue_.enqueue(nullptr); 
-  queueThread_.join();
-
+  // a start that's still running would resume the ring, so it finishes
+  // before the queue thread is shut down.
   if (stopThread_.joinable()) {
     stopThread_.join();
   }
   if (startThread_.joinable()) {
     startThread_.join();
   }
+
+  {
+    std::lock_guard<std::mutex> lock(queueLock_);
+    destroying_ = true;
+    stopped_ = true;
+  }
+
+  if (queueThread_.joinable()) {
+    queueResumed_.notify_one();
+    ring_.Interrupt();
+    queueThread_.join();
+  }
 }
 
-void ChunkProcessor::Process(short* input) {
-  std::vector<short> frame;
-  const short* iterator = (const short*)input;
-  unsigned long long sum = 0;
-  for (unsigned long i = 0; i < options_.samplesPerFrame; i++) {
-    const short value = *iterator++;
-    frame.push_back(value);
-    leadingBuffer_.push_back(value);
-    sileroBuffer_.push_back((float)value / (float)SHRT_MAX);
-    webrtcVadBuffer_.push_back(value);
-    sum += value * value;
-  }
-
-  double volume = sqrt((double)sum / (double)options_.samplesPerFrame);
-  if (leadingBuffer_.size() >
-      options_.leadingBufferFrames * options_.samplesPerFrame) {
-    leadingBuffer_.erase(
-        leadingBuffer_.begin(),
-        leadingBuffer_.begin() +
-            (leadingBuffer_.size() -
-             (options_.leadingBufferFrames * options_.samplesPerFrame)));
-  }
-
-  if (sileroBuffer_.size() > options_.sileroVadBufferSize) {
-    sileroBuffer_.erase(sileroBuffer_.begin(),
-                        sileroBuffer_.begin() + (sileroBuffer_.size() -
-                                                 options_.sileroVadBufferSize));
-  }
-
-  // typically, the number of samples per frame will be larger than the
-  // webrtcvad buffer size, so continually append the new audio to the end of
-  // the buffer, and process the buffer from left to right until it's too small
-  // for a webrtcvad call
-  while (webrtcVadBuffer_.size() >= options_.webrtcVadBufferSize) {
-    std::vector<short> buffer(
-        webrtcVadBuffer_.begin(),
-        webrtcVadBuffer_.begin() + options_.webrtcVadBufferSize);
-    webrtcVadResults_.push_back(
-        webrtcVad_.Process(buffer.data(), options_.webrtcVadBufferSize));
-    webrtcVadBuffer_.erase(
-        webrtcVadBuffer_.begin(),
-        webrtcVadBuffer_.begin() + options_.webrtcVadBufferSize);
-  }
-
-  if (webrtcVadResults_.size() > options_.webrtcVadResultsSize) {
-    webrtcVadResults_.erase(
-        webrtcVadResults_.begin(),
-        webrtcVadResults_.begin() +
-            (webrtcVadResults_.size() - options_.webrtcVadResultsSize));
+void ChunkProcessor::Process(const short* input) {
+  // without a Reset first, the vad is created here. that pads and clears the
+  // silero buffer, so it has to happen before this frame is pushed.
+  if (!sileroVad_) {
+    ResetSileroVad();
   }
 
+  frameStatistics_ =
+      AnalyzeFrame(input, sileroFrame_.data(), options_.samplesPerFrame);
+  double volume = sqrt((double)frameStatistics_.sumOfSquares /
+                       (double)options_.samplesPerFrame);
+  leadingBuffer_.Push(input, options_.samplesPerFrame);
+  sileroBuffer_.Push(sileroFrame_.data(), options_.samplesPerFrame);
+  ProcessWebrtcVad(input);
+
   if (framesUntilSileroVad_ > 0) {
     framesUntilSileroVad_--;
   }
@@ -129,41 +106,36 @@ void ChunkProcessor::Process(short* input) {
   // if we're speaking or any past webrtcvad result within the window is true,
   // then use the result from the silero vad
   double probability = 0.0;
-  if (speaking_ || webrtcVadResults_.size() != options_.webrtcVadResultsSize ||
+  int context = sileroVad_->ContextSize();
+  bool stateful = sileroVad_->Version() != SileroVadVersion::V3;
+  if (speaking_ || !webrtcVadResults_.Full() ||
       std::any_of(webrtcVadResults_.begin(), webrtcVadResults_.end(),
                   [](bool e) { return e; })) {
-    if (framesUntilSileroVad_ == 0) {
-      framesUntilSileroVad_ = options_.sileroVadRateLimit;
-
-      std::vector<int64_t> inputDimensions;
-      inputDimensions.push_back(1);
-      inputDimensions.push_back(sileroBuffer_.size());
-
-      std::vector<Ort::Value> inputTensors;
-      inputTensors.push_back(Ort::Value::CreateTensor<float>(
-          *ortMemory_, sileroBuffer_.data(), sileroBuffer_.size(),
-          inputDimensions.data(), inputDimensions.size()));
-
-      std::vector<float> outputTensorValues(2);
-      std::vector<int64_t> outputDimensions;
-      outputDimensions.push_back(1);
-      outputDimensions.push_back(2);
-
-      std::vector<Ort::Value> outputTensors;
-      outputTensors.push_back(Ort::Value::CreateTensor<float>(
-          *ortMemory_, outputTensorValues.data(), outputTensorValues.size(),
-          outputDimensions.data(), outputDimensions.size()));
-
-      std::vector<const char*> inputNames{"input"};
-      std::vector<const char*> outputNames{"output"};
-      ortSession_->Run(Ort::RunOptions{nullptr}, inputNames.data(),
-                       inputTensors.data(), 1, outputNames.data(),
-                       outputTensors.data(), 1);
+    if (stateful) {
+      // stateful models see each sample exactly once, so there's no need to
+      // rate limit. run every complete hop, keeping the context samples that
+      // prefix the next one, and report the most confident hop in the frame.
+      int hop = sileroVad_->HopSize();
+      double maximum = -1.0;
+      while (sileroBuffer_.Size() >= context + hop) {
+        maximum = std::max(maximum, sileroVad_->Process(sileroBuffer_.Data()));
+        sileroBuffer_.Discard(hop);
+      }
 
-      sileroVadProbability_ = outputTensorValues[1];
+      if (maximum >= 0.0) {
+        sileroVadProbability_ = maximum;
+      }
+    } else if (framesUntilSileroVad_ == 0) {
+      framesUntilSileroVad_ = options_.sileroVadRateLimit;
+      sileroVadProbability_ = sileroVad_->Process(
+          sileroBuffer_.end() - sileroVad_->InputSize());
     }
 
     probability = sileroVadProbability_;
+  } else if (stateful && sileroBuffer_.Size() > context) {
+    // skip audio that the first pass has ruled out, rather than letting it
+    // pile up for the next time the stateful model runs.
+    sileroBuffer_.Discard(sileroBuffer_.Size() - context);
   }
 
   bool speaking = speaking_ ? probability > options_.sileroVadSilenceThreshold
@@ -179,46 +151,119 @@ void ChunkProcessor::Process(short* input) {
   if (!speaking_ &&
       consecutiveSpeaking_ == options_.consecutiveFramesForSpeaking) {
     speaking_ = true;
+    if (options_.onChunkStartView != nullptr) {
+      options_.onChunkStartView(
+          Span<const short>(leadingBuffer_.Data(), leadingBuffer_.Size()));
+    }
     if (options_.onChunkStart != nullptr) {
-      options_.onChunkStart(leadingBuffer_);
+      options_.onChunkStart(
+          std::vector<short>(leadingBuffer_.begin(), leadingBuffer_.end()));
     }
   }
 
+  if (options_.onAudioView != nullptr) {
+    options_.onAudioView(Span<const short>(input, options_.samplesPerFrame),
+                         speaking_, volume, speaking, probability,
+                         consecutiveSilence_);
+  }
   if (options_.onAudio != nullptr) {
-    options_.onAudio(frame, speaking_, volume, speaking, probability,
-                     consecutiveSilence_);
+    options_.onAudio(
+        std::vector<short>(input, input + options_.samplesPerFrame), speaking_,
+        volume, speaking, probability, consecutiveSilence_);
   }
 
   if (speaking_ &&
       consecutiveSilence_ == options_.consecutiveFramesForSilence) {
     speaking_ = false;
-    leadingBuffer_.clear();
+    leadingBuffer_.Clear();
     if (options_.onChunkEnd != nullptr) {
       options_.onChunkEnd();
     }
   }
 }
 
+void ChunkProcessor::ProcessWebrtcVad(const short* input) {
+  size_t size = options_.webrtcVadBufferSize;
+  size_t frameSize = options_.samplesPerFrame;
+  size_t offset = 0;
+
+  // the buffer size doesn't have to divide the frame size, so first complete
+  // the buffer that was started with the end of the last frame.
+  if (webrtcVadRemainderSize_ > 0) {
+    offset = std::min(size - webrtcVadRemainderSize_, frameSize);
+    std::copy(input, input + offset,
+              webrtcVadRemainder_.begin() + webrtcVadRemainderSize_);
+    webrtcVadRemainderSize_ += offset;
+    if (webrtcVadRemainderSize_ < size) {
+      return;
+    }
+
+    webrtcVadResults_.Push(
+        webrtcVad_.Process(webrtcVadRemainder_.data(), size));
+    webrtcVadRemainderSize_ = 0;
+  }
+
+  // then run on the rest of the frame in place, and carry what's left over.
+  for (; offset + size <= frameSize; offset += size) {
+    webrtcVadResults_.Push(webrtcVad_.Process(input + offset, size));
+  }
+
+  webrtcVadRemainderSize_ = frameSize - offset;
+  std::copy(input + offset, input + frameSize, webrtcVadRemainder_.begin());
+}
+
+void ChunkProcessor::ResetSileroVad() {
+  if (!sileroVad_) {
+    sileroVad_ = std::make_unique<SileroVad>(
+        AcquireSileroVadSession(modelPath_, options_.sileroVadSessions),
+        options_.sampleRate, options_.sileroVadBufferSize);
+    if (options_.sileroVadBatchWindow > 0) {
+      sileroVad_->SetScheduler(&SileroVadScheduler::Get(
+          modelPath_, *sileroVad_, options_.sileroVadBatchWindow,
+          options_.sileroVadBatchSize, options_.sileroVadSessions));
+    }
+  }
+
+  // stateful models start from silence, and the v3 window is padded with
+  // silence so that it's always a full window.
+  sileroVad_->Reset();
+  sileroBuffer_.Clear();
+  size_t padding = sileroVad_->Version() == SileroVadVersion::V3
+                       ? sileroBuffer_.Capacity()
+                       : sileroVad_->ContextSize();
+  for (size_t i = 0; i < padding; i++) {
+    sileroBuffer_.Push(0.0f);
+  }
+}
+
 void ChunkProcessor::Reset() {
   consecutiveSilence_ = 0;
   consecutiveSpeaking_ = 0;
   framesUntilSileroVad_ = 0;
-  leadingBuffer_.clear();
+  leadingBuffer_.Clear();
   speaking_ = false;
   webrtcVad_.Reset();
-  webrtcVadBuffer_.clear();
-  webrtcVadResults_.clear();
-  short* audio;
-  while (queue_.try_dequeue(audio)) {
-  }
+  webrtcVadRemainderSize_ = 0;
+  webrtcVadResults_.Clear();
+  ResetSileroVad();
+  ring_.Clear();
 }
 
 void ChunkProcessor::Start() {
   toggleLock_.lock();
   startThread_ = std::thread([&] {
     Reset();
-    microphone_.Start();
-    stopped_ = false;
+    if (source_) {
+      source_->Start(&ring_);
+    }
+
+    ring_.Resume();
+    {
+      std::lock_guard<std::mutex> lock(queueLock_);
+      stopped_ = false;
+    }
+
+    queueResumed_.notify_one();
     toggleLock_.unlock();
   });
 }
@@ -226,8 +271,16 @@ void ChunkProcessor::Start() {
 void ChunkProcessor::Stop() {
   toggleLock_.lock();
   stopThread_ = std::thread([&] {
-    stopped_ = true;
-    microphone_.Stop();
+    {
+      std::lock_guard<std::mutex> lock(queueLock_);
+      stopped_ = true;
+    }
+
+    ring_.Interrupt();
+    if (source_) {
+      source_->Stop();
+    }
+
     toggleLock_.unlock();
   });
 }
@@ -1,5 +1,7 @@
 #include <portaudio.h>
 
+#include <cstring>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -7,9 +9,38 @@
 
 namespace speechrecorder {
 
+static std::mutex portAudioMutex;
+static int portAudioUsers = 0;
+
+std::mutex& PortAudioMutex() { return portAudioMutex; }
+
+PaError AcquirePortAudio() {
+  if (portAudioUsers == 0) {
+    PaError error = Pa_Initialize();
+    if (error != paNoError) {
+      return error;
+    }
+  }
+
+  portAudioUsers++;
+  return paNoError;
+}
+
+void ReleasePortAudio() {
+  portAudioUsers--;
+  if (portAudioUsers == 0) {
+    Pa_Terminate();
+  }
+}
+
 std::vector<Device> GetDevices() {
-  Pa_Initialize();
+  // portaudio only looks for devices when it's initialized, so unless a
+  // device is open, this picks up devices that were added since last time.
+  std::lock_guard<std::mutex> lock(PortAudioMutex());
   std::vector<Device> result;
+  if (AcquirePortAudio() != paNoError) {
+    return result;
+  }
 
   int count = Pa_GetDeviceCount();
   for (int i = 0; i < count; i++) {
@@ -31,6 +62,7 @@ std::vector<Device> GetDevices() {
     }
   }
 
+  ReleasePortAudio();
   return result;
 }
 
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "frame_ring.h"
+
+namespace speechrecorder {
+
+FrameRing::FrameRing(size_t samplesPerFrame, size_t frames,
+                     OverflowPolicy policy,
+                     std::chrono::microseconds pollInterval)
+    : samplesPerFrame_(samplesPerFrame),
+      policy_(policy),
+      generationCount_(1),
+      pollInterval_(pollInterval),
+      interrupted_(false),
+      write_(0),
+      read_(0),
+      reading_(none_),
+      overruns_(0),
+      underruns_(0),
+      frames_(0) {
+  frames = std::max(frames, (size_t)1);
+  generations_[0] = std::make_unique<Generation>();
+  generations_[0]->samples =
+      std::unique_ptr<short[]>(new short[samplesPerFrame * frames]());
+  generations_[0]->frames = frames;
+  generations_[0]->start = 0;
+}
+
+short* FrameRing::Slot(uint64_t frame) const {
+  // frames stay in the generation they were written to, which is the newest
+  // one that had started by then.
+  for (int i = generationCount_.load() - 1; i > 0; i--) {
+    const Generation& generation = *generations_[i];
+    if (generation.start <= frame) {
+      return generation.samples.get() +
+             (frame - generation.start) % generation.frames *
+                 samplesPerFrame_;
+    }
+  }
+
+  const Generation& generation = *generations_[0];
+  return generation.samples.get() +
+         frame % generation.frames * samplesPerFrame_;
+}
+
+short* FrameRing::Acquire() {
+  // the slot for the next frame last held the frame `frames` before it, so
+  // it's free once the processor has taken that frame and moved on.
+  int count = generationCount_.load(std::memory_order_relaxed);
+  const Generation& generation = *generations_[count - 1];
+  uint64_t frame = write_.load(std::memory_order_relaxed);
+  if (frame - generation.start < generation.frames) {
+    return Slot(frame);
+  }
+
+  uint64_t previous = frame - generation.frames;
+  uint64_t read = read_.load();
+  if (read <= previous) {
+    // the processor hasn't taken the previous frame, so the ring is full. the
+    // processor might take it first, in which case this frame is dropped.
+    if (policy_ == OverflowPolicy::DropOldest && read == previous &&
+        read_.compare_exchange_strong(read, previous + 1)) {
+      overruns_.fetch_add(1, std::memory_order_relaxed);
+      return Slot(frame);
+    }
+  } else if (reading_.load() != previous) {
+    return Slot(frame);
+  }
+
+  if (policy_ == OverflowPolicy::Grow && count < maxGenerations_) {
+    // frames that are already waiting stay where they are, and everything
+    // from here on goes into the new slots.
+    std::unique_ptr<Generation> grown = std::make_unique<Generation>();
+    grown->frames = generation.frames * 2;
+    grown->samples = std::unique_ptr<short[]>(
+        new short[samplesPerFrame_ * grown->frames]());
+    grown->start = frame;
+    generations_[count] = std::move(grown);
+    generationCount_.store(count + 1);
+    return Slot(frame);
+  }
+
+  overruns_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+void FrameRing::Write(const short* samples, size_t size) {
+  while (size > 0) {
+    if (filled_ == 0) {
+      frame_ = Acquire();
+    }
+
+    // a dropped frame is still consumed, so the next frame starts in the
+    // right place.
+    size_t count = std::min(size, samplesPerFrame_ - filled_);
+    if (frame_ != nullptr) {
+      std::memcpy(frame_ + filled_, samples, count * sizeof(short));
+    }
+
+    filled_ += count;
+    samples += count;
+    size -= count;
+    if (filled_ == samplesPerFrame_) {
+      frames_.fetch_add(1, std::memory_order_relaxed);
+      if (frame_ != nullptr) {
+        write_.store(write_.load(std::memory_order_relaxed) + 1);
+      }
+
+      filled_ = 0;
+    }
+  }
+}
+
+const short* FrameRing::Read() {
+  // the frame is marked as being read before it's taken, so that once the
+  // source sees it's been taken, it also sees that it's in use.
+  uint64_t read = read_.load();
+  while (read < write_.load()) {
+    reading_.store(read);
+    if (read_.compare_exchange_weak(read, read + 1)) {
+      return Slot(read);
+    }
+  }
+
+  reading_.store(none_);
+  return nullptr;
+}
+
+const short* FrameRing::Wait() {
+  // waking a sleeping thread is a system call, which the source might not be
+  // able to make, so rather than being woken, the processor polls.
+  while (!interrupted_) {
+    const short* frame = Read();
+    if (frame != nullptr) {
+      return frame;
+    }
+
+    std::this_thread::sleep_for(pollInterval_);
+  }
+
+  return nullptr;
+}
+
+void FrameRing::Interrupt() { interrupted_ = true; }
+
+void FrameRing::Resume() { interrupted_ = false; }
+
+void FrameRing::Clear() {
+  filled_ = 0;
+  uint64_t written = write_.load();
+  uint64_t read = read_.load();
+  while (read < written && !read_.compare_exchange_weak(read, written)) {
+  }
+}
+
+FrameRingStats FrameRing::Stats() const {
+  FrameRingStats stats;
+  uint64_t read = read_.load();
+  uint64_t written = write_.load();
+  stats.frames = frames_.load(std::memory_order_relaxed);
+  stats.overruns = overruns_.load(std::memory_order_relaxed);
+  stats.underruns = underruns_.load(std::memory_order_relaxed);
+  stats.depth = written > read ? written - read : 0;
+  stats.capacity = generations_[generationCount_.load() - 1]->frames;
+  return stats;
+}
+
+}  // namespace speechrecorder
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <bitset>
+#include <climits>
+
+#include "cpu_features.h"
+#include "frame_statistics.h"
+
+#if defined(SPEECHRECORDER_X86)
+#include <immintrin.h>
+#elif defined(SPEECHRECORDER_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET(name) __attribute__((target(name)))
+#else
+#define TARGET(name)
+#endif
+
+namespace speechrecorder {
+
+// multiplying by the reciprocal rather than dividing lets every
+// implementation produce the same floats.
+static const float kScale = 1.0f / (float)SHRT_MAX;
+
+// handles the samples that don't fill a vector, continuing from the partial
+// results of the vectorized loop.
+static void AnalyzeRemainder(const short* input, float* output, size_t start,
+                             size_t size, uint64_t& sum, int& maximum,
+                             int& minimum, int& crossings) {
+  for (size_t i = start; i < size; i++) {
+    int value = input[i];
+    output[i] = (float)value * kScale;
+    sum += (uint64_t)(value * value);
+    maximum = std::max(maximum, value);
+    minimum = std::min(minimum, value);
+    if (i > 0 && (input[i - 1] < 0) != (value < 0)) {
+      crossings++;
+    }
+  }
+}
+
+FrameStatistics AnalyzeFrameScalar(const short* input, float* output,
+                                   size_t size) {
+  uint64_t sum = 0;
+  int maximum = 0;
+  int minimum = 0;
+  int crossings = 0;
+  AnalyzeRemainder(input, output, 0, size, sum, maximum, minimum, crossings);
+
+  FrameStatistics result;
+  result.sumOfSquares = sum;
+  result.peak = std::max(maximum, -minimum);
+  result.zeroCrossings = crossings;
+  return result;
+}
+
+#ifdef SPEECHRECORDER_X86
+
+// in both x86 versions, each iteration compares a vector with the same
+// vector shifted back by one sample to find sign changes, so the loop starts
+// at the second sample. squares are summed in pairs by madd, which can only
+// overflow into the sign bit, so the pair sums are widened as unsigned.
+
+TARGET("sse2")
+static FrameStatistics AnalyzeFrameSse2(const short* input, float* output,
+                                        size_t size) {
+  const __m128 scale = _mm_set1_ps(kScale);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sums = zero;
+  __m128i maximums = zero;
+  __m128i minimums = zero;
+  int crossings = 0;
+  size_t i = 1;
+  for (; i + 8 <= size; i += 8) {
+    __m128i samples = _mm_loadu_si128((const __m128i*)(input + i));
+    __m128i previous = _mm_loadu_si128((const __m128i*)(input + i - 1));
+
+    __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+    __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+    _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+    _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+
+    __m128i squares = _mm_madd_epi16(samples, samples);
+    sums = _mm_add_epi64(sums, _mm_unpacklo_epi32(squares, zero));
+    sums = _mm_add_epi64(sums, _mm_unpackhi_epi32(squares, zero));
+
+    maximums = _mm_max_epi16(maximums, samples);
+    minimums = _mm_min_epi16(minimums, samples);
+
+    __m128i changes = _mm_xor_si128(_mm_srai_epi16(samples, 15),
+                                    _mm_srai_epi16(previous, 15));
+    crossings += (int)std::bitset<16>(_mm_movemask_epi8(changes)).count() / 2;
+  }
+
+  alignas(16) uint64_t sum[2];
+  alignas(16) short maximum[8];
+  alignas(16) short minimum[8];
+  _mm_store_si128((__m128i*)sum, sums);
+  _mm_store_si128((__m128i*)maximum, maximums);
+  _mm_store_si128((__m128i*)minimum, minimums);
+
+  uint64_t total = sum[0] + sum[1];
+  int highest = *std::max_element(maximum, maximum + 8);
+  int lowest = *std::min_element(minimum, minimum + 8);
+
+  // the first sample was skipped by the vector loop.
+  if (size > 0) {
+    AnalyzeRemainder(input, output, 0, 1, total, highest, lowest, crossings);
+  }
+  AnalyzeRemainder(input, output, std::max(i, (size_t)1), size, total,
+                   highest, lowest, crossings);
+
+  FrameStatistics result;
+  result.sumOfSquares = total;
+  result.peak = std::max(highest, -lowest);
+  result.zeroCrossings = crossings;
+  return result;
+}
+
+TARGET("avx2")
+static FrameStatistics AnalyzeFrameAvx2(const short* input, float* output,
+                                        size_t size) {
+  const __m256 scale = _mm256_set1_ps(kScale);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i sums = zero;
+  __m256i maximums = zero;
+  __m256i minimums = zero;
+  int crossings = 0;
+  size_t i = 1;
+  for (; i + 16 <= size; i += 16) {
+    __m256i samples = _mm256_loadu_si256((const __m256i*)(input + i));
+    __m256i previous = _mm256_loadu_si256((const __m256i*)(input + i - 1));
+
+    __m256i low = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(samples));
+    __m256i high = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(samples, 1));
+    _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(low), scale));
+    _mm256_storeu_ps(output + i + 8,
+                     _mm256_mul_ps(_mm256_cvtepi32_ps(high), scale));
+
+    __m256i squares = _mm256_madd_epi16(samples, samples);
+    sums = _mm256_add_epi64(sums, _mm256_unpacklo_epi32(squares, zero));
+    sums = _mm256_add_epi64(sums, _mm256_unpackhi_epi32(squares, zero));
+
+    maximums = _mm256_max_epi16(maximums, samples);
+    minimums = _mm256_min_epi16(minimums, samples);
+
+    __m256i changes = _mm256_xor_si256(_mm256_srai_epi16(samples, 15),
+                                       _mm256_srai_epi16(previous, 15));
+    crossings +=
+        (int)std::bitset<32>((unsigned)_mm256_movemask_epi8(changes)).count() /
+        2;
+  }
+
+  alignas(32) uint64_t sum[4];
+  alignas(32) short maximum[16];
+  alignas(32) short minimum[16];
+  _mm256_store_si256((__m256i*)sum, sums);
+  _mm256_store_si256((__m256i*)maximum, maximums);
+  _mm256_store_si256((__m256i*)minimum, minimums);
+
+  uint64_t total = sum[0] + sum[1] + sum[2] + sum[3];
+  int highest = *std::max_element(maximum, maximum + 16);
+  int lowest = *std::min_element(minimum, minimum + 16);
+  if (size > 0) {
+    AnalyzeRemainder(input, output, 0, 1, total, highest, lowest, crossings);
+  }
+  AnalyzeRemainder(input, output, std::max(i, (size_t)1), size, total,
+                   highest, lowest, crossings);
+
+  FrameStatistics result;
+  result.sumOfSquares = total;
+  result.peak = std::max(highest, -lowest);
+  result.zeroCrossings = crossings;
+  return result;
+}
+
+#endif
+
+#ifdef SPEECHRECORDER_NEON
+
+static FrameStatistics AnalyzeFrameNeon(const short* input, float* output,
+                                        size_t size) {
+  const float32x4_t scale = vdupq_n_f32(kScale);
+  uint64x2_t sums = vdupq_n_u64(0);
+  int16x8_t maximums = vdupq_n_s16(0);
+  int16x8_t minimums = vdupq_n_s16(0);
+  int32x4_t changes = vdupq_n_s32(0);
+  size_t i = 1;
+  for (; i + 8 <= size; i += 8) {
+    int16x8_t samples = vld1q_s16(input + i);
+    int16x8_t previous = vld1q_s16(input + i - 1);
+
+    int32x4_t low = vmovl_s16(vget_low_s16(samples));
+    int32x4_t high = vmovl_s16(vget_high_s16(samples));
+    vst1q_f32(output + i, vmulq_f32(vcvtq_f32_s32(low), scale));
+    vst1q_f32(output + i + 4, vmulq_f32(vcvtq_f32_s32(high), scale));
+
+    // each square fits in 31 bits, so they can be widened as unsigned.
+    int16x4_t lowSamples = vget_low_s16(samples);
+    int16x4_t highSamples = vget_high_s16(samples);
+    sums = vpadalq_u32(
+        sums, vreinterpretq_u32_s32(vmull_s16(lowSamples, lowSamples)));
+    sums = vpadalq_u32(
+        sums, vreinterpretq_u32_s32(vmull_s16(highSamples, highSamples)));
+
+    maximums = vmaxq_s16(maximums, samples);
+    minimums = vminq_s16(minimums, samples);
+
+    // sign changes are -1, so this counts down.
+    changes = vpadalq_s16(changes, veorq_s16(vshrq_n_s16(samples, 15),
+                                             vshrq_n_s16(previous, 15)));
+  }
+
+  uint64_t total = vaddvq_u64(sums);
+  int highest = vmaxvq_s16(maximums);
+  int lowest = vminvq_s16(minimums);
+  int crossings = -vaddvq_s32(changes);
+  if (size > 0) {
+    AnalyzeRemainder(input, output, 0, 1, total, highest, lowest, crossings);
+  }
+  AnalyzeRemainder(input, output, std::max(i, (size_t)1), size, total,
+                   highest, lowest, crossings);
+
+  FrameStatistics result;
+  result.sumOfSquares = total;
+  result.peak = std::max(highest, -lowest);
+  result.zeroCrossings = crossings;
+  return result;
+}
+
+#endif
+
+typedef FrameStatistics (*AnalyzeFrameFunction)(const short*, float*, size_t);
+
+static AnalyzeFrameFunction SelectAnalyzeFrame() {
+#if defined(SPEECHRECORDER_X86)
+  if (WebRtc_GetCPUInfo(kAVX2)) {
+    return AnalyzeFrameAvx2;
+  }
+  if (WebRtc_GetCPUInfo(kSSE2)) {
+    return AnalyzeFrameSse2;
+  }
+#elif defined(SPEECHRECORDER_NEON)
+  return AnalyzeFrameNeon;
+#endif
+  return AnalyzeFrameScalar;
+}
+
+FrameStatistics AnalyzeFrame(const short* input, float* output, size_t size) {
+  static const AnalyzeFrameFunction function = SelectAnalyzeFrame();
+  return function(input, output, size);
+}
+
+}  // namespace speechrecorder
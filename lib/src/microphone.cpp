@@ -1,53 +1,74 @@
 #include <portaudio.h>
 
+#include <algorithm>
 #include <cstring>
 #include <functional>
 #include <iostream>
 #include <vector>
 
+#include "devices.h"
 #include "microphone.h"
+#include "realtime.h"
 #include "webrtcvad.h"
 
-using namespace moodycamel;
-
 namespace speechrecorder {
 
 int callback(const void* input, void* output, unsigned long samplesPerFrame,
              const PaStreamCallbackTimeInfo* timeInfo,
              PaStreamCallbackFlags statusFlags, void* callbackData) {
+  RealtimeScope realtime;
   if (input == nullptr || callbackData == nullptr) {
     return paContinue;
   }
 
+  // audio the device lost before it got to us is counted alongside the
+  // ring's own overruns.
   MicrophoneCallbackData* data = (MicrophoneCallbackData*)callbackData;
-  short* audio = (short*)input;
-  for (int i = 0; i < samplesPerFrame; i++) {
-    data->buffer->at((data->bufferIndex + i) % data->buffer->size()) = audio[i];
+  if (statusFlags & paInputOverflow) {
+    data->ring->CountOverrun();
+  }
+  if (statusFlags & paInputUnderflow) {
+    data->ring->CountUnderrun();
+  }
+
+  const short* audio = (const short*)input;
+  if (data->resampler == nullptr) {
+    data->ring->Write(audio, samplesPerFrame);
+    return paContinue;
   }
 
-  data->queue->enqueue(data->buffer->data() + data->bufferIndex);
-  data->bufferIndex =
-      (data->bufferIndex + samplesPerFrame) % data->buffer->size();
+  // resampled audio doesn't line up with the device's buffers, but the ring
+  // holds on to partial frames. the constructor reserves the resampler's
+  // buffers for a callback's worth of audio, so this doesn't allocate.
+  std::vector<short>& resampled = *data->resampled;
+  resampled.clear();
+  data->resampler->Process(audio, samplesPerFrame, resampled);
+  data->ring->Write(resampled.data(), resampled.size());
   return paContinue;
 }
 
 Microphone::Microphone(int device, int samplesPerFrame, int sampleRate,
-                       BlockingReaderWriterQueue<short*>* queue)
+                       int captureSampleRate)
     : device_(device),
       samplesPerFrame_(samplesPerFrame),
-      sampleRate_(sampleRate) {
-  for (int i = 0; i < samplesPerFrame * 10; i++) {
-    buffer_.push_back(0);
-  }
-
-  callbackData_ = {&buffer_, 0, queue};
-  PaError error = Pa_Initialize();
-  if (error != paNoError) {
-    HandleError(error, "Initialize");
+      sampleRate_(sampleRate),
+      captureSampleRate_(captureSampleRate > 0 ? captureSampleRate
+                                               : sampleRate) {
+  if (captureSampleRate_ != sampleRate_) {
+    resampler_ = std::make_unique<Resampler>(captureSampleRate_, sampleRate_);
+    resampler_->Reserve((size_t)((long long)samplesPerFrame *
+                                 captureSampleRate_ / sampleRate_));
+    resampled_.reserve(samplesPerFrame * 4);
+    callbackData_.resampler = resampler_.get();
+    callbackData_.resampled = &resampled_;
   }
+}
 
-  if (device_ == -1) {
-    device_ = Pa_GetDefaultInputDevice();
+Microphone::~Microphone() {
+  Stop();
+  std::lock_guard<std::mutex> lock(PortAudioMutex());
+  if (initialized_) {
+    ReleasePortAudio();
   }
 }
 
@@ -59,8 +80,24 @@ void Microphone::HandleError(PaError error, const std::string& message) {
   exit(error);
 }
 
-void Microphone::Start() {
+void Microphone::Start(FrameRing* ring) {
+  // portaudio is only initialized once the microphone is actually used, so
+  // that constructing one is cheap. other microphones might be starting or
+  // stopping on other threads at the same time.
+  std::lock_guard<std::mutex> lock(PortAudioMutex());
   PaError error = paNoError;
+  if (!initialized_) {
+    error = AcquirePortAudio();
+    if (error != paNoError) {
+      HandleError(error, "Initialize");
+    }
+
+    initialized_ = true;
+    if (device_ == -1) {
+      device_ = Pa_GetDefaultInputDevice();
+    }
+  }
+
   PaStreamParameters parameters;
   parameters.channelCount = 1;
   parameters.sampleFormat = paInt16;
@@ -69,21 +106,37 @@ void Microphone::Start() {
       Pa_GetDeviceInfo(parameters.device)->defaultLowInputLatency;
   parameters.hostApiSpecificStreamInfo = 0;
 
-  error = Pa_OpenStream(&stream_, &parameters, 0, sampleRate_, samplesPerFrame_,
-                        paClipOff, callback, &callbackData_);
+  callbackData_.ring = ring;
+
+  // capture the same duration per callback at the device's rate, so that
+  // each callback produces about a frame once it's resampled.
+  if (resampler_) {
+    resampler_->Reset();
+    resampled_.clear();
+  }
+
+  unsigned long framesPerBuffer =
+      (unsigned long)((long long)samplesPerFrame_ * captureSampleRate_ /
+                      sampleRate_);
+  error = Pa_OpenStream(&stream_, &parameters, 0, captureSampleRate_,
+                        framesPerBuffer, paClipOff, callback, &callbackData_);
   if (error != paNoError) {
     HandleError(error, "Open Stream");
   }
 
-  Pa_StartStream(stream_);
+  error = Pa_StartStream(stream_);
   if (error != paNoError) {
     HandleError(error, "Start Stream");
   }
 }
 
 void Microphone::Stop() {
-  Pa_AbortStream(stream_);
-  Pa_CloseStream(stream_);
+  std::lock_guard<std::mutex> lock(PortAudioMutex());
+  if (stream_ != nullptr) {
+    Pa_AbortStream(stream_);
+    Pa_CloseStream(stream_);
+    stream_ = nullptr;
+  }
 }
 
 }  // namespace speechrecorder
@@ -0,0 +1,63 @@
+#include "realtime.h"
+
+#ifdef SPEECHRECORDER_REALTIME_CHECKS
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace speechrecorder {
+
+static thread_local int realtimeDepth = 0;
+
+RealtimeScope::RealtimeScope() { realtimeDepth++; }
+
+RealtimeScope::~RealtimeScope() { realtimeDepth--; }
+
+static void CheckAllocation(size_t size) {
+  // iostreams can allocate, so this goes straight to stderr.
+  if (realtimeDepth > 0) {
+    fprintf(stderr, "Allocated %zu bytes on a real-time audio thread\n", size);
+    abort();
+  }
+}
+
+}  // namespace speechrecorder
+
+// everything on the audio path is c++, so replacing the global allocation
+// functions catches every allocation that could happen there. aligned
+// allocations keep the default implementation.
+void* operator new(size_t size) {
+  speechrecorder::CheckAllocation(size);
+  void* result = malloc(size > 0 ? size : 1);
+  if (result == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return result;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  speechrecorder::CheckAllocation(size);
+  return malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept { free(pointer); }
+
+void operator delete[](void* pointer) noexcept { free(pointer); }
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+  free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+  free(pointer);
+}
+
+#endif
@@ -0,0 +1,250 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "replay_source.h"
+#include "resampler.h"
+#include "wav_reader.h"
+
+namespace speechrecorder {
+
+// raw 16-bit samples from a file or a pipe. reads wait for data in short
+// intervals, so that a replay can be stopped while a pipe is idle.
+class PcmStream {
+ private:
+#ifdef _WIN32
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  bool pipe_ = false;
+#else
+  int file_ = -1;
+#endif
+  std::vector<char> bytes_;
+  size_t pending_ = 0;
+
+ public:
+  explicit PcmStream(const std::string& path) {
+#ifdef _WIN32
+    file_ = CreateFileA(path.c_str(), GENERIC_READ,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    pipe_ = file_ != INVALID_HANDLE_VALUE &&
+            GetFileType(file_) == FILE_TYPE_PIPE;
+#else
+    // without O_NONBLOCK, opening a pipe would wait for a writer.
+    file_ = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+#endif
+  }
+
+  PcmStream(const PcmStream&) = delete;
+  PcmStream& operator=(const PcmStream&) = delete;
+
+  ~PcmStream() {
+#ifdef _WIN32
+    if (file_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(file_);
+    }
+#else
+    if (file_ >= 0) {
+      close(file_);
+    }
+#endif
+  }
+
+#ifdef _WIN32
+  bool IsOpen() const { return file_ != INVALID_HANDLE_VALUE; }
+#else
+  bool IsOpen() const { return file_ >= 0; }
+#endif
+
+  // reads up to `size` samples into `output`. returns the number of samples
+  // read, 0 if nothing arrived in time, or -1 at the end of the stream.
+  long Read(short* output, size_t size) {
+    // a pipe can split a sample between writes, so an odd byte is kept for
+    // the next read.
+    bytes_.resize(size * sizeof(short));
+    long count;
+#ifdef _WIN32
+    // reading a pipe blocks until it has data, so like poll() below, it's
+    // peeked at for up to 100ms, and only as much as is there is read. a
+    // pipe whose writer has closed it fails to peek.
+    DWORD space = (DWORD)(bytes_.size() - pending_);
+    if (pipe_) {
+      DWORD available = 0;
+      for (int waited = 0;; waited += 10) {
+        if (!PeekNamedPipe(file_, nullptr, 0, nullptr, &available, nullptr)) {
+          return -1;
+        }
+        if (available > 0) {
+          break;
+        }
+        if (waited >= 100) {
+          return 0;
+        }
+
+        Sleep(10);
+      }
+
+      space = std::min(space, available);
+    }
+
+    DWORD read = 0;
+    if (!ReadFile(file_, bytes_.data() + pending_, space, &read, nullptr) ||
+        read == 0) {
+      return -1;
+    }
+
+    count = (long)read;
+#else
+    // a pipe that has never had a writer doesn't poll as readable, and one
+    // whose writer has closed it polls as hung up and reads as empty.
+    pollfd descriptor = {file_, POLLIN, 0};
+    if (poll(&descriptor, 1, 100) <= 0) {
+      return 0;
+    }
+
+    count = (long)read(file_, bytes_.data() + pending_,
+                       bytes_.size() - pending_);
+    if (count == 0) {
+      return -1;
+    }
+    if (count < 0) {
+      return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    }
+#endif
+
+    size_t total = pending_ + (size_t)count;
+    size_t samples = total / sizeof(short);
+    memcpy(output, bytes_.data(), samples * sizeof(short));
+    pending_ = total % sizeof(short);
+    if (pending_ > 0) {
+      bytes_[0] = bytes_[total - 1];
+    }
+
+    return (long)samples;
+  }
+};
+
+ReplaySource::ReplaySource(const std::string& path, int samplesPerFrame,
+                           int sampleRate, int rawSampleRate, double speed)
+    : path_(path),
+      samplesPerFrame_(samplesPerFrame),
+      sampleRate_(sampleRate),
+      rawSampleRate_(rawSampleRate > 0 ? rawSampleRate : sampleRate),
+      speed_(speed > 0.0 ? speed : 1.0),
+      stopped_(true) {}
+
+ReplaySource::~ReplaySource() { Stop(); }
+
+void ReplaySource::Start(FrameRing* ring) {
+  Stop();
+  stopped_ = false;
+  thread_ = std::thread([this, ring] { Replay(ring); });
+}
+
+void ReplaySource::Stop() {
+  stopped_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void ReplaySource::Replay(FrameRing* ring) {
+  // anything that doesn't open as a wav file is read as raw pcm. opening a
+  // pipe for reading would block until it has a writer, so only regular
+  // files are tried as wav files.
+  std::unique_ptr<WavReader> wav;
+  std::unique_ptr<PcmStream> pcm;
+  int inputRate = rawSampleRate_;
+#ifndef _WIN32
+  struct stat info;
+  if (stat(path_.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+#endif
+  {
+    wav = std::make_unique<WavReader>(path_);
+  }
+
+  if (wav && wav->IsOpen()) {
+    inputRate = wav->SampleRate();
+  } else {
+    wav.reset();
+    pcm = std::make_unique<PcmStream>(path_);
+    if (!pcm->IsOpen()) {
+      return;
+    }
+  }
+
+  // audio is read in blocks that last as long as a frame, like a microphone
+  // delivers it, and each block is held back until it would have finished
+  // being captured.
+  Resampler resampler(inputRate, sampleRate_);
+  size_t block = std::max(
+      (size_t)((long long)samplesPerFrame_ * inputRate / sampleRate_),
+      (size_t)1);
+  std::vector<short> raw(block);
+  std::vector<short> resampled;
+  resampled.reserve(samplesPerFrame_ * 4);
+  double rate = inputRate * speed_;
+  uint64_t captured = 0;
+  uint64_t written = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (!stopped_) {
+    const short* audio = raw.data();
+    size_t size = 0;
+    bool end;
+    if (wav) {
+      // the last block of a file is usually short.
+      size = (size_t)std::min((uint64_t)block, wav->Remaining());
+      audio = size > 0 ? wav->Read(size) : nullptr;
+      end = audio == nullptr || size < block;
+      if (audio == nullptr) {
+        audio = raw.data();
+        size = 0;
+      }
+    } else {
+      long count = pcm->Read(raw.data(), block);
+      end = count < 0;
+      size = end ? 0 : (size_t)count;
+    }
+
+    captured += size;
+    std::this_thread::sleep_until(
+        start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(captured / rate)));
+    if (resampler.Passthrough()) {
+      ring->Write(audio, size);
+      written += size;
+    } else {
+      resampled.clear();
+      resampler.Process(audio, size, resampled);
+      ring->Write(resampled.data(), resampled.size());
+      written += resampled.size();
+    }
+
+    if (end) {
+      // the ring only queues whole frames, so the last one is padded with
+      // silence rather than dropped.
+      size_t partial = (size_t)(written % samplesPerFrame_);
+      if (partial > 0) {
+        resampled.assign(samplesPerFrame_ - partial, 0);
+        ring->Write(resampled.data(), resampled.size());
+      }
+
+      return;
+    }
+  }
+}
+
+}  // namespace speechrecorder
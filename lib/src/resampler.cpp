@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "resampler.h"
+
+namespace speechrecorder {
+
+// the webrtc kernels work on 10ms blocks of 48 kHz audio.
+static const size_t kBlockSize = 480;
+
+// the sinc filter spans this many input samples on each side of an output
+// sample, and is precomputed at this many fractional offsets.
+static const int kTaps = 16;
+static const int kPhases = 128;
+static const double kPi = 3.14159265358979323846;
+
+Resampler::Resampler(int inputRate, int outputRate, int channels)
+    : inputRate_(inputRate),
+      outputRate_(outputRate),
+      channels_(std::max(channels, 1)),
+      scratch_(kBlockSize + 32),
+      step_((double)inputRate / (double)outputRate) {
+  // cut off just below the lower of the two nyquist frequencies, so that
+  // downsampling doesn't alias.
+  double cutoff = 0.45 * std::min(1.0, (double)outputRate / (double)inputRate);
+  filters_.resize(kPhases * 2 * kTaps);
+  for (int phase = 0; phase < kPhases; phase++) {
+    float* filter = filters_.data() + phase * 2 * kTaps;
+    double sum = 0.0;
+    for (int i = 0; i < 2 * kTaps; i++) {
+      double x = (i - kTaps + 1) - (double)phase / kPhases;
+      double sinc = x == 0.0 ? 2.0 * cutoff
+                             : sin(2.0 * kPi * cutoff * x) / (kPi * x);
+      double window = 0.42 + 0.5 * cos(kPi * x / kTaps) +
+                      0.08 * cos(2.0 * kPi * x / kTaps);
+      filter[i] = (float)(sinc * window);
+      sum += filter[i];
+    }
+
+    for (int i = 0; i < 2 * kTaps; i++) {
+      filter[i] = (float)(filter[i] / sum);
+    }
+  }
+
+  Reset();
+}
+
+void Resampler::Process(const short* input, size_t frames,
+                        std::vector<short>& output) {
+  const short* mono = input;
+  if (channels_ > 1) {
+    mono_.resize(frames);
+    for (size_t i = 0; i < frames; i++) {
+      int sum = 0;
+      for (int j = 0; j < channels_; j++) {
+        sum += input[i * channels_ + j];
+      }
+
+      mono_[i] = (short)(sum / channels_);
+    }
+
+    mono = mono_.data();
+  }
+
+  if (inputRate_ == outputRate_) {
+    output.insert(output.end(), mono, mono + frames);
+  } else if (inputRate_ == 48000 &&
+             (outputRate_ == 16000 || outputRate_ == 8000)) {
+    ProcessBlocks(mono, frames, output);
+  } else {
+    ProcessSinc(mono, frames, output);
+  }
+}
+
+void Resampler::ProcessBlocks(const short* input, size_t size,
+                              std::vector<short>& output) {
+  pending_.insert(pending_.end(), input, input + size);
+  size_t ratio = inputRate_ / outputRate_;
+  size_t offset = 0;
+  for (; offset + kBlockSize <= pending_.size(); offset += kBlockSize) {
+    size_t end = output.size();
+    output.resize(end + kBlockSize / ratio);
+    if (outputRate_ == 16000) {
+      WebRtcSpl_Resample48khzTo16khz(pending_.data() + offset,
+                                     output.data() + end, &state16_,
+                                     scratch_.data());
+    } else {
+      WebRtcSpl_Resample48khzTo8khz(pending_.data() + offset,
+                                    output.data() + end, &state8_,
+                                    scratch_.data());
+    }
+  }
+
+  pending_.erase(pending_.begin(), pending_.begin() + offset);
+}
+
+void Resampler::ProcessSinc(const short* input, size_t size,
+                            std::vector<short>& output) {
+  for (size_t i = 0; i < size; i++) {
+    history_.push_back((float)input[i]);
+  }
+
+  // each output sample is centered between the input samples around it, and
+  // needs kTaps samples of history on each side.
+  while ((size_t)position_ + kTaps < history_.size()) {
+    size_t index = (size_t)position_;
+    int phase = (int)((position_ - index) * kPhases);
+    const float* filter = filters_.data() + phase * 2 * kTaps;
+    const float* samples = history_.data() + index - kTaps + 1;
+    float sum = 0.0f;
+    for (int i = 0; i < 2 * kTaps; i++) {
+      sum += samples[i] * filter[i];
+    }
+
+    output.push_back(
+        (short)std::min(std::max(std::lround(sum), (long)SHRT_MIN),
+                        (long)SHRT_MAX));
+    position_ += step_;
+  }
+
+  size_t discard = std::min((size_t)position_ - kTaps + 1, history_.size());
+  history_.erase(history_.begin(), history_.begin() + discard);
+  position_ -= discard;
+}
+
+void Resampler::Reserve(size_t frames) {
+  // a partial block, or the taps on both sides of the next output sample, are
+  // kept between calls.
+  mono_.reserve(frames);
+  pending_.reserve(kBlockSize + frames);
+  history_.reserve(2 * kTaps + frames);
+}
+
+void Resampler::Reset() {
+  WebRtcSpl_ResetResample48khzTo16khz(&state16_);
+  WebRtcSpl_ResetResample48khzTo8khz(&state8_);
+  pending_.clear();
+  history_.assign(kTaps, 0.0f);
+  position_ = kTaps;
+}
+
+}  // namespace speechrecorder
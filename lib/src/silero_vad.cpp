@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "silero_vad.h"
+#include "silero_vad_scheduler.h"
+
+namespace speechrecorder {
+
+// sessions are shared across processors and kept for the life of the
+// process. each model path has its own pool, which grows on demand to the
+// requested number of sessions and is then handed out round robin.
+struct SessionPool {
+  std::vector<std::unique_ptr<Ort::Session>> sessions;
+  size_t next = 0;
+};
+
+static std::mutex ortMutex_;
+static std::unique_ptr<Ort::Env> ortEnv_;
+static std::unordered_map<std::string, SessionPool> ortSessions_;
+
+// loads sessions into the pool until it has `sessions` of them. must be
+// called with ortMutex_ held.
+static SessionPool& LoadSessions(const std::string& modelPath,
+                                 size_t sessions) {
+  if (!ortEnv_) {
+    ortEnv_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING,
+                                         "SpeechRecorder::ChunkProcessor");
+  }
+
+  SessionPool& pool = ortSessions_[modelPath];
+  while (pool.sessions.size() < sessions) {
+    Ort::SessionOptions sessionOptions;
+    sessionOptions.SetIntraOpNumThreads(1);
+#ifdef _WIN32
+    std::wstring wstring(modelPath.begin(), modelPath.end());
+    pool.sessions.push_back(std::make_unique<Ort::Session>(
+        *ortEnv_, wstring.c_str(), sessionOptions));
+
+#else
+    pool.sessions.push_back(std::make_unique<Ort::Session>(
+        *ortEnv_, modelPath.c_str(), sessionOptions));
+#endif
+  }
+
+  return pool;
+}
+
+void PreloadSileroVadSession(const std::string& modelPath, int sessions) {
+  std::lock_guard<std::mutex> lock(ortMutex_);
+  LoadSessions(modelPath, (size_t)std::max(sessions, 1));
+}
+
+Ort::Session& AcquireSileroVadSession(const std::string& modelPath,
+                                      int sessions) {
+  std::lock_guard<std::mutex> lock(ortMutex_);
+  size_t size = (size_t)std::max(sessions, 1);
+  SessionPool& pool = ortSessions_[modelPath];
+
+  // each call loads at most one more session, so a pool only grows as far as
+  // processors need it.
+  LoadSessions(modelPath, std::min(pool.sessions.size() + 1, size));
+  Ort::Session& result = *pool.sessions[pool.next % pool.sessions.size()];
+  pool.next++;
+  return result;
+}
+
+static SileroVadVersion DetectVersion(Ort::Session& session) {
+  Ort::AllocatorWithDefaultOptions allocator;
+  SileroVadVersion result = SileroVadVersion::V3;
+  for (size_t i = 0; i < session.GetInputCount(); i++) {
+    char* name = session.GetInputName(i, allocator);
+    if (strcmp(name, "state") == 0) {
+      result = SileroVadVersion::V5;
+    } else if (strcmp(name, "h") == 0) {
+      result = SileroVadVersion::V4;
+    }
+
+    allocator.Free(name);
+  }
+
+  return result;
+}
+
+SileroVad::SileroVad(Ort::Session& session, int sampleRate,
+                     size_t windowSize)
+    : session_(session),
+      memory_(Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator,
+                                         OrtMemType::OrtMemTypeDefault)),
+      runOptions_(nullptr),
+      version_(DetectVersion(session)),
+      contextSize_(version_ != SileroVadVersion::V5 ? 0
+                   : sampleRate == 8000             ? 32
+                                                    : 64),
+      hopSize_(sampleRate == 8000 ? 256 : 512),
+      inputSize_(version_ == SileroVadVersion::V3 ? windowSize
+                                                  : contextSize_ + hopSize_),
+      input_(inputSize_),
+      sampleRate_(sampleRate),
+      output_(version_ == SileroVadVersion::V3 ? 2 : 1),
+      state_(version_ == SileroVadVersion::V3 ? 0 : 2 * 128),
+      stateOutput_(state_.size()),
+      binding_(session) {
+  tensors_.reserve(8);
+  Bind("input", input_.data(), input_.size(), {1, (int64_t)input_.size()},
+       true);
+  Bind("output", output_.data(), output_.size(), {1, (int64_t)output_.size()},
+       false);
+
+  if (version_ != SileroVadVersion::V3) {
+    tensors_.push_back(Ort::Value::CreateTensor<int64_t>(memory_, &sampleRate_,
+                                                         1, nullptr, 0));
+    binding_.BindInput("sr", tensors_.back());
+  }
+
+  if (version_ == SileroVadVersion::V4) {
+    // h and c are each [2, 1, 64], stored back to back in the state buffer.
+    size_t half = state_.size() / 2;
+    Bind("h", state_.data(), half, {2, 1, 64}, true);
+    Bind("c", state_.data() + half, half, {2, 1, 64}, true);
+    Bind("hn", stateOutput_.data(), half, {2, 1, 64}, false);
+    Bind("cn", stateOutput_.data() + half, half, {2, 1, 64}, false);
+  } else if (version_ == SileroVadVersion::V5) {
+    Bind("state", state_.data(), state_.size(), {2, 1, 128}, true);
+    Bind("stateN", stateOutput_.data(), stateOutput_.size(), {2, 1, 128},
+         false);
+  }
+}
+
+void SileroVad::Bind(const char* name, float* data, size_t size,
+                     std::vector<int64_t> dimensions, bool input) {
+  tensors_.push_back(Ort::Value::CreateTensor<float>(
+      memory_, data, size, dimensions.data(), dimensions.size()));
+  if (input) {
+    binding_.BindInput(name, tensors_.back());
+  } else {
+    binding_.BindOutput(name, tensors_.back());
+  }
+}
+
+double SileroVad::Process(const float* audio) {
+  std::memcpy(input_.data(), audio, inputSize_ * sizeof(float));
+  if (scheduler_ != nullptr) {
+    return scheduler_->Process(input_.data(), state_.data());
+  }
+
+  session_.Run(runOptions_, binding_);
+  if (version_ == SileroVadVersion::V3) {
+    return output_[1];
+  }
+
+  std::copy(stateOutput_.begin(), stateOutput_.end(), state_.begin());
+  return output_[0];
+}
+
+void SileroVad::Reset() { std::fill(state_.begin(), state_.end(), 0.0f); }
+
+}  // namespace speechrecorder
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "silero_vad_scheduler.h"
+
+namespace speechrecorder {
+
+// each stateful stream carries one or two recurrent tensors of shape
+// [2, 1, width] (h and c for v4, state for v5). batched, they become
+// [2, B, width], so states are gathered before and scattered after each run.
+static const size_t stateSize = 2 * 128;
+
+static size_t StateTensors(SileroVadVersion version) {
+  return version == SileroVadVersion::V4 ? 2 : 1;
+}
+
+static size_t StateWidth(SileroVadVersion version) {
+  return version == SileroVadVersion::V4 ? 64 : 128;
+}
+
+SileroVadScheduler::SileroVadScheduler(Ort::Session& session,
+                                       const SileroVad& vad, int window,
+                                       int batchSize)
+    : session_(session),
+      memory_(Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator,
+                                         OrtMemType::OrtMemTypeDefault)),
+      runOptions_(nullptr),
+      version_(vad.Version()),
+      inputSize_(vad.InputSize()),
+      sampleRate_(vad.SampleRate()),
+      window_(window),
+      batchSize_(std::max(batchSize, 1)),
+      input_(batchSize_ * inputSize_),
+      output_(batchSize_ * 2),
+      state_(batchSize_ * stateSize),
+      stateOutput_(batchSize_ * stateSize) {
+  // a batch of b uses the start of each buffer, with the states laid out as
+  // [2, b, width] for that b.
+  size_t tensors = StateTensors(version_);
+  int64_t width = StateWidth(version_);
+  int64_t outputWidth = version_ == SileroVadVersion::V3 ? 2 : 1;
+  tensors_.reserve(batchSize_ * (2 + 2 * tensors) + 1);
+  bindings_.reserve(batchSize_);
+  if (version_ != SileroVadVersion::V3) {
+    tensors_.push_back(Ort::Value::CreateTensor<int64_t>(memory_, &sampleRate_,
+                                                         1, nullptr, 0));
+  }
+
+  for (int64_t batch = 1; batch <= (int64_t)batchSize_; batch++) {
+    bindings_.emplace_back(session_);
+    Ort::IoBinding& binding = bindings_.back();
+    Bind(binding, "input", input_.data(), batch * inputSize_,
+         {batch, (int64_t)inputSize_}, true);
+    Bind(binding, "output", output_.data(), batch * outputWidth,
+         {batch, outputWidth}, false);
+    if (version_ == SileroVadVersion::V3) {
+      continue;
+    }
+
+    binding.BindInput("sr", tensors_.front());
+    const char* inputNames[] = {"h", "c"};
+    const char* outputNames[] = {"hn", "cn"};
+    if (version_ == SileroVadVersion::V5) {
+      inputNames[0] = "state";
+      outputNames[0] = "stateN";
+    }
+
+    for (size_t t = 0; t < tensors; t++) {
+      size_t offset = t * 2 * batch * width;
+      Bind(binding, inputNames[t], state_.data() + offset, 2 * batch * width,
+           {2, batch, width}, true);
+      Bind(binding, outputNames[t], stateOutput_.data() + offset,
+           2 * batch * width, {2, batch, width}, false);
+    }
+  }
+
+  batch_.reserve(batchSize_);
+  pending_.reserve(batchSize_ * 2);
+  thread_ = std::thread([&] { Run(); });
+}
+
+SileroVadScheduler::~SileroVadScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+
+  requested_.notify_all();
+  thread_.join();
+}
+
+void SileroVadScheduler::Bind(Ort::IoBinding& binding, const char* name,
+                              float* data, size_t size,
+                              std::vector<int64_t> dimensions, bool input) {
+  tensors_.push_back(Ort::Value::CreateTensor<float>(
+      memory_, data, size, dimensions.data(), dimensions.size()));
+  if (input) {
+    binding.BindInput(name, tensors_.back());
+  } else {
+    binding.BindOutput(name, tensors_.back());
+  }
+}
+
+SileroVadScheduler& SileroVadScheduler::Get(const std::string& modelPath,
+                                            const SileroVad& vad, int window,
+                                            int batchSize, int sessions) {
+  static std::mutex mutex;
+  static std::map<std::string, std::unique_ptr<SileroVadScheduler>> schedulers;
+
+  std::string key = modelPath + ":" + std::to_string(vad.SampleRate()) + ":" +
+                    std::to_string(vad.InputSize()) + ":" +
+                    std::to_string(window) + ":" + std::to_string(batchSize) +
+                    ":" + std::to_string(sessions);
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<SileroVadScheduler>& scheduler = schedulers[key];
+  if (!scheduler) {
+    scheduler = std::make_unique<SileroVadScheduler>(
+        AcquireSileroVadSession(modelPath, sessions), vad, window, batchSize);
+  }
+
+  return *scheduler;
+}
+
+double SileroVadScheduler::Process(const float* input, float* state) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  Request request;
+  request.input = input;
+  request.state = state;
+  pending_.push_back(&request);
+  requested_.notify_one();
+  completed_.wait(lock, [&] { return request.done; });
+  return request.result;
+}
+
+void SileroVadScheduler::Run() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      requested_.wait(lock, [&] { return stopped_ || !pending_.empty(); });
+      if (stopped_) {
+        return;
+      }
+
+      // give other processors a chance to join the batch.
+      requested_.wait_for(lock, window_, [&] {
+        return stopped_ || pending_.size() >= batchSize_;
+      });
+
+      size_t count = std::min(pending_.size(), batchSize_);
+      batch_.assign(pending_.begin(), pending_.begin() + count);
+      pending_.erase(pending_.begin(), pending_.begin() + count);
+    }
+
+    int64_t batch = batch_.size();
+    for (size_t b = 0; b < batch_.size(); b++) {
+      std::copy(batch_[b]->input, batch_[b]->input + inputSize_,
+                input_.begin() + b * inputSize_);
+    }
+
+    size_t tensors = StateTensors(version_);
+    int64_t width = StateWidth(version_);
+    if (version_ != SileroVadVersion::V3) {
+      for (size_t b = 0; b < batch_.size(); b++) {
+        for (size_t t = 0; t < tensors; t++) {
+          for (size_t l = 0; l < 2; l++) {
+            const float* source = batch_[b]->state + (t * 2 + l) * width;
+            std::copy(source, source + width,
+                      state_.begin() + t * 2 * batch * width +
+                          (l * batch + b) * width);
+          }
+        }
+      }
+    }
+
+    session_.Run(runOptions_, bindings_[batch - 1]);
+
+    if (version_ != SileroVadVersion::V3) {
+      for (size_t b = 0; b < batch_.size(); b++) {
+        for (size_t t = 0; t < tensors; t++) {
+          for (size_t l = 0; l < 2; l++) {
+            const float* source = stateOutput_.data() + t * 2 * batch * width +
+                                  (l * batch + b) * width;
+            std::copy(source, source + width,
+                      batch_[b]->state + (t * 2 + l) * width);
+          }
+        }
+      }
+    }
+
+    int64_t outputWidth = version_ == SileroVadVersion::V3 ? 2 : 1;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (size_t b = 0; b < batch_.size(); b++) {
+        batch_[b]->result = output_[b * outputWidth + outputWidth - 1];
+        batch_[b]->done = true;
+      }
+    }
+
+    completed_.notify_all();
+  }
+}
+
+}  // namespace speechrecorder
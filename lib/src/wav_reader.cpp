@@ -0,0 +1,133 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define DR_WAV_IMPLEMENTATION
+#include "wav_reader.h"
+
+namespace speechrecorder {
+
+WavReader::WavReader(const std::string& path) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return;
+  }
+
+  file_ = file;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    return;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    return;
+  }
+
+  mapping_ = mapping;
+  data_ = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data_ == nullptr) {
+    return;
+  }
+
+  size_ = (size_t)size.QuadPart;
+#else
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return;
+  }
+
+  // the mapping stays valid after the descriptor is closed.
+  struct stat info;
+  void* data = MAP_FAILED;
+  if (fstat(file, &info) == 0 && info.st_size > 0) {
+    data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  }
+
+  close(file);
+  if (data == MAP_FAILED) {
+    return;
+  }
+
+  madvise(data, info.st_size, MADV_SEQUENTIAL);
+  data_ = (const unsigned char*)data;
+  size_ = info.st_size;
+#endif
+
+  if (!drwav_init_memory(&wav_, data_, size_, nullptr)) {
+    return;
+  }
+
+  open_ = true;
+  direct_ = wav_.translatedFormatTag == DR_WAVE_FORMAT_PCM &&
+            wav_.bitsPerSample == 16 && wav_.channels == 1 &&
+            wav_.dataChunkDataPos % sizeof(short) == 0 &&
+            wav_.dataChunkDataPos + wav_.totalPCMFrameCount * sizeof(short) <=
+                size_;
+}
+
+WavReader::~WavReader() {
+  if (open_) {
+    drwav_uninit(&wav_);
+  }
+
+#ifdef _WIN32
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_ != nullptr) {
+    CloseHandle(mapping_);
+  }
+  if (file_ != nullptr) {
+    CloseHandle(file_);
+  }
+#else
+  if (data_ != nullptr) {
+    munmap((void*)data_, size_);
+  }
+#endif
+}
+
+const short* WavReader::Read(size_t size) {
+  if (!open_ || position_ + size > wav_.totalPCMFrameCount) {
+    return nullptr;
+  }
+
+  if (direct_) {
+    const short* result =
+        (const short*)(data_ + wav_.dataChunkDataPos) + position_;
+    position_ += size;
+    return result;
+  }
+
+  // anything else is decoded one block at a time, and channels are averaged.
+  size_t channels = wav_.channels;
+  frames_.resize(size * channels);
+  buffer_.resize(size);
+  if (drwav_read_pcm_frames_s16(&wav_, size, frames_.data()) != size) {
+    return nullptr;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    int sum = 0;
+    for (size_t j = 0; j < channels; j++) {
+      sum += frames_[i * channels + j];
+    }
+
+    buffer_[i] = (short)(sum / (int)channels);
+  }
+
+  position_ += size;
+  return buffer_.data();
+}
+
+}  // namespace speechrecorder
@@ -1,31 +1,1103 @@
+#include <algorithm>
+#include <cstring>
+
+#include "cpu_features.h"
 #include "microphone.h"
 #include "webrtcvad.h"
 
+extern "C" {
+#include "webrtc/common_audio/vad/vad_core.h"
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET(name) __attribute__((target(name)))
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define TARGET(name)
+#define ALWAYS_INLINE __forceinline
+#else
+#define TARGET(name)
+#define ALWAYS_INLINE inline
+#endif
+
 namespace speechrecorder {
 
 WebrtcVad::WebrtcVad(int level, int sampleRate)
     : level_(level), sampleRate_(sampleRate) {
+  WebRtcSpl_Init();
   Reset();
 }
 
-WebrtcVad::~WebrtcVad() {
-  if (instance_ != nullptr) {
-    WebRtcVad_Free(instance_);
+bool WebrtcVad::Process(const int16_t* buffer, size_t size) {
+  // a VadInst is a VadInstT, which webrtc_vad.c only hides behind a pointer.
+  return WebRtcVad_Process((VadInst*)&state_, sampleRate_, buffer, size) == 1;
+}
+
+void WebrtcVad::Reset() {
+  WebRtcVad_InitCore(&state_);
+  WebRtcVad_set_mode_core(&state_, level_);
+}
+
+void WebrtcVad::Snapshot(WebrtcVadState& snapshot) const { snapshot = state_; }
+
+void WebrtcVad::Restore(const WebrtcVadState& snapshot) { state_ = snapshot; }
+
+static const int kLanes = WebrtcVadBank::kLanes;
+
+// the longest frame the vad accepts is 30ms at 48 kHz, which is 240 samples
+// once it has been downsampled to 8 kHz.
+static const size_t kMaxFrameSize = 1440;
+static const size_t kMaxNarrowSize = 240;
+
+// the constants below are copied from the webrtc vad sources, which keep them
+// private.
+
+// vad_filterbank.c
+static const int16_t kLogConst = 24660;
+static const int16_t kLogEnergyIntPart = 14336;
+static const int16_t kHpZeroCoefs[3] = {6631, -13262, 6631};
+static const int16_t kHpPoleCoefs[3] = {16384, -7756, 5620};
+static const int16_t kAllPassCoefsQ15[2] = {20972, 5571};
+static const int16_t kOffsetVector[6] = {368, 368, 272, 176, 176, 176};
+
+// vad_sp.c
+static const int16_t kAllPassCoefsQ13[2] = {5243, 1392};
+static const int16_t kSmoothingDown = 6553;
+static const int16_t kSmoothingUp = 32439;
+
+// vad_gmm.c
+static const int32_t kCompVar = 22005;
+static const int16_t kLog2Exp = 5909;
+
+// vad_core.c
+static const int16_t kSpectrumWeight[kNumChannels] = {6, 8, 10, 12, 14, 16};
+static const int16_t kNoiseUpdateConst = 655;
+static const int16_t kSpeechUpdateConst = 6554;
+static const int16_t kBackEta = 154;
+static const int16_t kMinimumDifference[kNumChannels] = {544, 544, 576,
+                                                         576, 576, 576};
+static const int16_t kMaximumSpeech[kNumChannels] = {11392, 11392, 11520,
+                                                     11520, 11520, 11520};
+static const int16_t kMinimumMean[kNumGaussians] = {640, 768};
+static const int16_t kMaximumNoise[kNumChannels] = {9216, 9088, 8960,
+                                                    8832, 8704, 8576};
+static const int16_t kNoiseDataWeights[kTableSize] = {34, 62, 72, 66, 53, 25,
+                                                      94, 66, 56, 62, 75, 103};
+static const int16_t kSpeechDataWeights[kTableSize] = {
+    48, 82, 45, 87, 50, 47, 80, 46, 83, 41, 78, 81};
+static const int16_t kMaxSpeechFrames = 6;
+static const int16_t kMinStd = 384;
+
+// the state of a VadInstT, for each of kLanes streams. every field has the
+// streams as its last dimension, so that a loop over the streams reads and
+// writes consecutive values.
+struct WebrtcVadLanes {
+  int32_t downsamplingStates[4][kLanes];
+  WebRtcSpl_State48khzTo8khz resamplerStates[kLanes];
+  int16_t noiseMeans[kTableSize][kLanes];
+  int16_t speechMeans[kTableSize][kLanes];
+  int16_t noiseStds[kTableSize][kLanes];
+  int16_t speechStds[kTableSize][kLanes];
+  int32_t frameCounters[kLanes];
+  int16_t overHangs[kLanes];
+  int16_t speechFrames[kLanes];
+  int16_t ages[16 * kNumChannels][kLanes];
+  int16_t smallestValues[16 * kNumChannels][kLanes];
+  int16_t medians[kNumChannels][kLanes];
+  int16_t upperStates[5][kLanes];
+  int16_t lowerStates[5][kLanes];
+  int16_t highPassStates[4][kLanes];
+
+  // the last result of each lane, with the overhang folded in the way
+  // vad_core.c does it.
+  int32_t results[kLanes];
+
+  // these depend only on the level, so they're shared by every stream.
+  int16_t overHangMax1[3];
+  int16_t overHangMax2[3];
+  int16_t individual[3];
+  int16_t total[3];
+};
+
+template <typename T, size_t N>
+static void CopyToLane(T (&lanes)[N][kLanes], int lane, const T* values) {
+  for (size_t i = 0; i < N; i++) {
+    lanes[i][lane] = values[i];
   }
 }
 
-bool WebrtcVad::Process(int16_t* buffer, size_t size) {
-  return WebRtcVad_Process(instance_, sampleRate_, buffer, size) == 1;
+template <typename T, size_t N>
+static void CopyFromLane(const T (&lanes)[N][kLanes], int lane, T* values) {
+  for (size_t i = 0; i < N; i++) {
+    values[i] = lanes[i][lane];
+  }
 }
 
-void WebrtcVad::Reset() {
-  if (instance_ != nullptr) {
-    WebRtcVad_Free(instance_);
+// copies the state of a single stream into a lane. the fields that depend on
+// the level are left alone.
+static void StoreLane(WebrtcVadLanes& lanes, int lane, const VadInstT& self) {
+  CopyToLane(lanes.downsamplingStates, lane, self.downsampling_filter_states);
+  CopyToLane(lanes.noiseMeans, lane, self.noise_means);
+  CopyToLane(lanes.speechMeans, lane, self.speech_means);
+  CopyToLane(lanes.noiseStds, lane, self.noise_stds);
+  CopyToLane(lanes.speechStds, lane, self.speech_stds);
+  CopyToLane(lanes.ages, lane, self.index_vector);
+  CopyToLane(lanes.smallestValues, lane, self.low_value_vector);
+  CopyToLane(lanes.medians, lane, self.mean_value);
+  CopyToLane(lanes.upperStates, lane, self.upper_state);
+  CopyToLane(lanes.lowerStates, lane, self.lower_state);
+  CopyToLane(lanes.highPassStates, lane, self.hp_filter_state);
+  lanes.resamplerStates[lane] = self.state_48_to_8;
+  lanes.frameCounters[lane] = self.frame_counter;
+  lanes.overHangs[lane] = self.over_hang;
+  lanes.speechFrames[lane] = self.num_of_speech;
+  lanes.results[lane] = self.vad;
+}
+
+// the reverse of StoreLane(), into a VadInstT that has already been
+// initialized for the level.
+static void LoadLane(const WebrtcVadLanes& lanes, int lane, VadInstT& self) {
+  CopyFromLane(lanes.downsamplingStates, lane, self.downsampling_filter_states);
+  CopyFromLane(lanes.noiseMeans, lane, self.noise_means);
+  CopyFromLane(lanes.speechMeans, lane, self.speech_means);
+  CopyFromLane(lanes.noiseStds, lane, self.noise_stds);
+  CopyFromLane(lanes.speechStds, lane, self.speech_stds);
+  CopyFromLane(lanes.ages, lane, self.index_vector);
+  CopyFromLane(lanes.smallestValues, lane, self.low_value_vector);
+  CopyFromLane(lanes.medians, lane, self.mean_value);
+  CopyFromLane(lanes.upperStates, lane, self.upper_state);
+  CopyFromLane(lanes.lowerStates, lane, self.lower_state);
+  CopyFromLane(lanes.highPassStates, lane, self.hp_filter_state);
+  self.state_48_to_8 = lanes.resamplerStates[lane];
+  self.frame_counter = lanes.frameCounters[lane];
+  self.over_hang = lanes.overHangs[lane];
+  self.num_of_speech = lanes.speechFrames[lane];
+  self.vad = lanes.results[lane];
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+
+// a value for each lane. with the compiler's vector extensions, every
+// operation on these becomes avx2 or sse2 instructions, depending on the
+// function that the kernels below are inlined into.
+typedef int32_t Vector __attribute__((vector_size(4 * kLanes)));
+typedef uint32_t UnsignedVector __attribute__((vector_size(4 * kLanes)));
+typedef int16_t ShortVector __attribute__((vector_size(2 * kLanes)));
+typedef int64_t LongVector __attribute__((vector_size(8 * kLanes)));
+typedef double DoubleVector __attribute__((vector_size(8 * kLanes)));
+
+// the vector is wrapped in a struct and passed by reference, so that no
+// vector type is ever passed to or returned from a function. the default
+// clone has no avx, and gcc would note the abi change for every helper.
+struct Lanes {
+  Vector values;
+};
+
+static_assert(kLanes == 8, "Splat() fills eight lanes");
+
+static ALWAYS_INLINE Lanes Splat(int32_t value) {
+  Lanes lanes = {{value, value, value, value, value, value, value, value}};
+  return lanes;
+}
+
+static ALWAYS_INLINE Lanes Load(const int16_t* values) {
+  ShortVector shorts;
+  memcpy(&shorts, values, sizeof(shorts));
+  return {__builtin_convertvector(shorts, Vector)};
+}
+
+static ALWAYS_INLINE Lanes Load(const int32_t* values) {
+  Lanes lanes;
+  memcpy(&lanes.values, values, sizeof(lanes.values));
+  return lanes;
+}
+
+// keeps the low 16 bits of each lane, like a cast to int16_t.
+static ALWAYS_INLINE void Store(int16_t* values, const Lanes& lanes) {
+  ShortVector shorts = __builtin_convertvector(lanes.values, ShortVector);
+  memcpy(values, &shorts, sizeof(shorts));
+}
+
+static ALWAYS_INLINE void Store(int32_t* values, const Lanes& lanes) {
+  memcpy(values, &lanes.values, sizeof(lanes.values));
+}
+
+static ALWAYS_INLINE Lanes operator+(const Lanes& a, const Lanes& b) {
+  return {a.values + b.values};
+}
+
+static ALWAYS_INLINE Lanes operator-(const Lanes& a, const Lanes& b) {
+  return {a.values - b.values};
+}
+
+static ALWAYS_INLINE Lanes operator-(const Lanes& a) { return {-a.values}; }
+
+static ALWAYS_INLINE Lanes operator*(const Lanes& a, const Lanes& b) {
+  return {a.values * b.values};
+}
+
+static ALWAYS_INLINE Lanes operator&(const Lanes& a, const Lanes& b) {
+  return {a.values & b.values};
+}
+
+static ALWAYS_INLINE Lanes operator|(const Lanes& a, const Lanes& b) {
+  return {a.values | b.values};
+}
+
+static ALWAYS_INLINE Lanes operator^(const Lanes& a, const Lanes& b) {
+  return {a.values ^ b.values};
+}
+
+static ALWAYS_INLINE Lanes operator~(const Lanes& a) { return {~a.values}; }
+
+static ALWAYS_INLINE Lanes operator>>(const Lanes& a, const Lanes& b) {
+  return {a.values >> b.values};
+}
+
+static ALWAYS_INLINE Lanes operator>>(const Lanes& a, int bits) {
+  return {a.values >> bits};
+}
+
+// comparisons give -1 where they hold and 0 elsewhere.
+static ALWAYS_INLINE Lanes operator<(const Lanes& a, const Lanes& b) {
+  return {a.values < b.values};
+}
+
+static ALWAYS_INLINE Lanes operator>(const Lanes& a, const Lanes& b) {
+  return {a.values > b.values};
+}
+
+static ALWAYS_INLINE Lanes operator>=(const Lanes& a, const Lanes& b) {
+  return {a.values >= b.values};
+}
+
+static ALWAYS_INLINE Lanes operator==(const Lanes& a, const Lanes& b) {
+  return {a.values == b.values};
+}
+
+// the webrtc vad relies on signed arithmetic wrapping around in a few places.
+static ALWAYS_INLINE Lanes WrappingAdd(const Lanes& a, const Lanes& b) {
+  return {(Vector)((UnsignedVector)a.values + (UnsignedVector)b.values)};
+}
+
+static ALWAYS_INLINE Lanes WrappingMultiply(const Lanes& a, const Lanes& b) {
+  return {(Vector)((UnsignedVector)a.values * (UnsignedVector)b.values)};
+}
+
+static ALWAYS_INLINE Lanes ShiftLeft(const Lanes& lanes, int bits) {
+  return {(Vector)((UnsignedVector)lanes.values << bits)};
+}
+
+// the same as WebRtcSpl_DivW32W16() for a nonzero denominator. the quotient
+// of a 32-bit and a 16-bit integer is never close enough to the next integer
+// for a double to round across it, so truncating gives the exact result, and
+// unlike integer division this can be vectorized.
+static ALWAYS_INLINE Lanes Divide(const Lanes& numerator,
+                                  const Lanes& denominator) {
+  DoubleVector quotient =
+      __builtin_convertvector(numerator.values, DoubleVector) /
+      __builtin_convertvector(denominator.values, DoubleVector);
+  return {__builtin_convertvector(quotient, Vector)};
+}
+
+// the same as WebRtcSpl_NormW32() for a positive value. a double holds any
+// 32-bit integer exactly, so its exponent is the position of the highest bit.
+static ALWAYS_INLINE Lanes NormPositive(const Lanes& value) {
+  LongVector bits =
+      (LongVector)__builtin_convertvector(value.values, DoubleVector);
+  return Splat(30 + 1023) - Lanes{__builtin_convertvector(bits >> 52, Vector)};
+}
+
+#else
+
+// without vector extensions, each operation is a loop over the lanes.
+struct Lanes {
+  int32_t values[kLanes];
+};
+
+template <typename Function>
+static ALWAYS_INLINE Lanes Map(const Lanes& a, const Lanes& b,
+                               Function function) {
+  Lanes result;
+  for (int lane = 0; lane < kLanes; lane++) {
+    result.values[lane] = function(a.values[lane], b.values[lane]);
+  }
+  return result;
+}
+
+static ALWAYS_INLINE Lanes Splat(int32_t value) {
+  Lanes lanes;
+  std::fill(lanes.values, lanes.values + kLanes, value);
+  return lanes;
+}
+
+static ALWAYS_INLINE Lanes Load(const int16_t* values) {
+  Lanes lanes;
+  std::copy(values, values + kLanes, lanes.values);
+  return lanes;
+}
+
+static ALWAYS_INLINE Lanes Load(const int32_t* values) {
+  Lanes lanes;
+  std::copy(values, values + kLanes, lanes.values);
+  return lanes;
+}
+
+static ALWAYS_INLINE void Store(int16_t* values, const Lanes& lanes) {
+  for (int lane = 0; lane < kLanes; lane++) {
+    values[lane] = (int16_t)lanes.values[lane];
+  }
+}
+
+static ALWAYS_INLINE void Store(int32_t* values, const Lanes& lanes) {
+  std::copy(lanes.values, lanes.values + kLanes, values);
+}
+
+static ALWAYS_INLINE Lanes operator+(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) { return x + y; });
+}
+
+static ALWAYS_INLINE Lanes operator-(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) { return x - y; });
+}
+
+static ALWAYS_INLINE Lanes operator-(const Lanes& a) { return Splat(0) - a; }
+
+static ALWAYS_INLINE Lanes operator*(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) { return x * y; });
+}
+
+static ALWAYS_INLINE Lanes operator&(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) { return x & y; });
+}
+
+static ALWAYS_INLINE Lanes operator|(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) { return x | y; });
+}
+
+static ALWAYS_INLINE Lanes operator^(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) { return x ^ y; });
+}
+
+static ALWAYS_INLINE Lanes operator~(const Lanes& a) { return a ^ Splat(-1); }
+
+static ALWAYS_INLINE Lanes operator>>(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) { return x >> y; });
+}
+
+static ALWAYS_INLINE Lanes operator>>(const Lanes& a, int bits) {
+  return a >> Splat(bits);
+}
+
+// comparisons give -1 where they hold and 0 elsewhere, like vector ones.
+static ALWAYS_INLINE Lanes operator<(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) { return x < y ? -1 : 0; });
+}
+
+static ALWAYS_INLINE Lanes operator>(const Lanes& a, const Lanes& b) {
+  return b < a;
+}
+
+static ALWAYS_INLINE Lanes operator>=(const Lanes& a, const Lanes& b) {
+  return ~(a < b);
+}
+
+static ALWAYS_INLINE Lanes operator==(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) { return x == y ? -1 : 0; });
+}
+
+static ALWAYS_INLINE Lanes WrappingAdd(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) {
+    return (int32_t)((uint32_t)x + (uint32_t)y);
+  });
+}
+
+static ALWAYS_INLINE Lanes WrappingMultiply(const Lanes& a, const Lanes& b) {
+  return Map(a, b, [](int32_t x, int32_t y) {
+    return (int32_t)((uint32_t)x * (uint32_t)y);
+  });
+}
+
+static ALWAYS_INLINE Lanes ShiftLeft(const Lanes& lanes, int bits) {
+  return Map(lanes, Splat(bits), [](int32_t x, int32_t y) {
+    return (int32_t)((uint32_t)x << y);
+  });
+}
+
+static ALWAYS_INLINE Lanes Divide(const Lanes& numerator,
+                                  const Lanes& denominator) {
+  return Map(numerator, denominator, [](int32_t x, int32_t y) {
+    return (int32_t)((double)x / (double)y);
+  });
+}
+
+static ALWAYS_INLINE Lanes NormPositive(const Lanes& value) {
+  return Map(value, value, [](int32_t x, int32_t) {
+    return (int32_t)WebRtcSpl_NormW32(x);
+  });
+}
+
+#endif
+
+// a for the lanes where mask is -1, and b where it is 0.
+static ALWAYS_INLINE Lanes Select(const Lanes& mask, const Lanes& a,
+                                  const Lanes& b) {
+  return (a & mask) | (b & ~mask);
+}
+
+static ALWAYS_INLINE Lanes Min(const Lanes& a, const Lanes& b) {
+  return Select(a < b, a, b);
+}
+
+static ALWAYS_INLINE Lanes Max(const Lanes& a, const Lanes& b) {
+  return Select(a > b, a, b);
+}
+
+// sign extends the low 16 bits of each lane, like a cast to int16_t.
+static ALWAYS_INLINE Lanes Wrap16(const Lanes& lanes) {
+  return ShiftLeft(lanes, 16) >> 16;
+}
+
+// WebRtcVad_Downsampling() on every lane.
+static ALWAYS_INLINE void Downsampling(const int16_t (*input)[kLanes],
+                                       int16_t (*output)[kLanes],
+                                       int32_t (*states)[kLanes],
+                                       size_t size) {
+  const Lanes upperCoefficient = Splat(kAllPassCoefsQ13[0]);
+  const Lanes lowerCoefficient = Splat(kAllPassCoefsQ13[1]);
+  Lanes upper = Load(states[0]);
+  Lanes lower = Load(states[1]);
+  for (size_t i = 0; i < size / 2; i++) {
+    Lanes even = Load(input[2 * i]);
+    Lanes odd = Load(input[2 * i + 1]);
+    Lanes upperOut = Wrap16((upper >> 1) + ((upperCoefficient * even) >> 14));
+    upper = even - ((upperCoefficient * upperOut) >> 12);
+    Lanes lowerOut = Wrap16((lower >> 1) + ((lowerCoefficient * odd) >> 14));
+    lower = odd - ((lowerCoefficient * lowerOut) >> 12);
+    Store(output[i], upperOut + lowerOut);
+  }
+
+  Store(states[0], upper);
+  Store(states[1], lower);
+}
+
+// SplitFilter() from vad_filterbank.c on every lane.
+static ALWAYS_INLINE void SplitFilter(const int16_t (*input)[kLanes],
+                                      size_t size, int16_t* upperState,
+                                      int16_t* lowerState,
+                                      int16_t (*highPass)[kLanes],
+                                      int16_t (*lowPass)[kLanes]) {
+  const Lanes upperCoefficient = Splat(kAllPassCoefsQ15[0]);
+  const Lanes lowerCoefficient = Splat(kAllPassCoefsQ15[1]);
+  Lanes upper = ShiftLeft(Load(upperState), 16);
+  Lanes lower = ShiftLeft(Load(lowerState), 16);
+  for (size_t i = 0; i < size / 2; i++) {
+    Lanes even = Load(input[2 * i]);
+    Lanes odd = Load(input[2 * i + 1]);
+    Lanes upperOut = WrappingAdd(upper, upperCoefficient * even) >> 16;
+    upper = ShiftLeft(even, 14) - upperCoefficient * upperOut;
+    upper = WrappingAdd(upper, upper);
+    Lanes lowerOut = WrappingAdd(lower, lowerCoefficient * odd) >> 16;
+    lower = ShiftLeft(odd, 14) - lowerCoefficient * lowerOut;
+    lower = WrappingAdd(lower, lower);
+    Store(highPass[i], upperOut - lowerOut);
+    Store(lowPass[i], upperOut + lowerOut);
+  }
+
+  Store(upperState, upper >> 16);
+  Store(lowerState, lower >> 16);
+}
+
+// the part of LogOfEnergy() from vad_filterbank.c after the energy has been
+// calculated, for a single lane.
+static void LogOfScaledEnergy(uint32_t energy, int shifts, int16_t offset,
+                              int16_t* totalEnergy, int16_t* logEnergy) {
+  if (energy == 0) {
+    *logEnergy = offset;
+    return;
+  }
+
+  int normalizingShifts = 17 - WebRtcSpl_NormU32(energy);
+  int16_t log2Energy = kLogEnergyIntPart;
+  shifts += normalizingShifts;
+  if (normalizingShifts < 0) {
+    energy <<= -normalizingShifts;
+  } else {
+    energy >>= normalizingShifts;
+  }
+
+  log2Energy += (int16_t)((energy & 0x00003FFF) >> 4);
+  *logEnergy = (int16_t)(((kLogConst * log2Energy) >> 19) +
+                         ((shifts * kLogConst) >> 9));
+  if (*logEnergy < 0) {
+    *logEnergy = 0;
+  }
+
+  *logEnergy += offset;
+  if (*totalEnergy <= kMinEnergy) {
+    if (shifts >= 0) {
+      *totalEnergy += kMinEnergy + 1;
+    } else {
+      *totalEnergy += (int16_t)(energy >> -shifts);
+    }
+  }
+}
+
+// LogOfEnergy() from vad_filterbank.c on every lane, with WebRtcSpl_Energy()
+// inlined so that the squares can be summed in lockstep.
+static ALWAYS_INLINE void LogOfEnergy(const int16_t (*input)[kLanes],
+                                      size_t size, int16_t offset,
+                                      int16_t* totalEnergy,
+                                      int16_t* logEnergy) {
+  const Lanes zero = Splat(0);
+
+  // like WebRtcSpl_GetScalingSquare(), the absolute value wraps around for
+  // -32768, which leaves it out of the maximum.
+  Lanes maximum = Splat(-1);
+  for (size_t i = 0; i < size; i++) {
+    Lanes value = Load(input[i]);
+    maximum = Max(maximum, Wrap16(Select(value > zero, value, -value)));
+  }
+
+  Lanes bits = Splat(WebRtcSpl_GetSizeInBits((uint32_t)size));
+  Lanes norm = NormPositive(maximum * maximum);
+  Lanes scaling = Select((maximum == zero) | (norm > bits), zero, bits - norm);
+  Lanes energy = zero;
+  for (size_t i = 0; i < size; i++) {
+    Lanes value = Load(input[i]);
+    energy = WrappingAdd(energy, (value * value) >> scaling);
+  }
+
+  int32_t energies[kLanes];
+  int32_t shifts[kLanes];
+  Store(energies, energy);
+  Store(shifts, scaling);
+  for (int lane = 0; lane < kLanes; lane++) {
+    LogOfScaledEnergy((uint32_t)energies[lane], shifts[lane], offset,
+                      &totalEnergy[lane], &logEnergy[lane]);
+  }
+}
+
+// HighPassFilter() from vad_filterbank.c on every lane.
+static ALWAYS_INLINE void HighPassFilter(const int16_t (*input)[kLanes],
+                                         size_t size, int16_t (*states)[kLanes],
+                                         int16_t (*output)[kLanes]) {
+  Lanes inputs[2] = {Load(states[0]), Load(states[1])};
+  Lanes outputs[2] = {Load(states[2]), Load(states[3])};
+  for (size_t i = 0; i < size; i++) {
+    Lanes value = Load(input[i]);
+    Lanes sum = Splat(kHpZeroCoefs[0]) * value +
+                Splat(kHpZeroCoefs[1]) * inputs[0] +
+                Splat(kHpZeroCoefs[2]) * inputs[1];
+    inputs[1] = inputs[0];
+    inputs[0] = value;
+    sum = sum - Splat(kHpPoleCoefs[1]) * outputs[0] -
+          Splat(kHpPoleCoefs[2]) * outputs[1];
+    outputs[1] = outputs[0];
+    outputs[0] = Wrap16(sum >> 14);
+    Store(output[i], outputs[0]);
+  }
+
+  Store(states[0], inputs[0]);
+  Store(states[1], inputs[1]);
+  Store(states[2], outputs[0]);
+  Store(states[3], outputs[1]);
+}
+
+// WebRtcVad_CalculateFeatures() on every lane.
+static ALWAYS_INLINE void CalculateFeatures(WebrtcVadLanes& lanes,
+                                            const int16_t (*input)[kLanes],
+                                            size_t size,
+                                            int16_t (*features)[kLanes],
+                                            int16_t* totalEnergy) {
+  int16_t highPass120[120][kLanes];
+  int16_t lowPass120[120][kLanes];
+  int16_t highPass60[60][kLanes];
+  int16_t lowPass60[60][kLanes];
+  size_t half = size / 2;
+  for (int lane = 0; lane < kLanes; lane++) {
+    totalEnergy[lane] = 0;
+  }
+
+  // split at 2000 Hz, then the upper band at 3000 Hz.
+  SplitFilter(input, size, lanes.upperStates[0], lanes.lowerStates[0],
+              highPass120, lowPass120);
+  SplitFilter(highPass120, half, lanes.upperStates[1], lanes.lowerStates[1],
+              highPass60, lowPass60);
+  LogOfEnergy(highPass60, half / 2, kOffsetVector[5], totalEnergy,
+              features[5]);
+  LogOfEnergy(lowPass60, half / 2, kOffsetVector[4], totalEnergy, features[4]);
+
+  // split the lower band at 1000 Hz, 500 Hz, and 250 Hz.
+  SplitFilter(lowPass120, half, lanes.upperStates[2], lanes.lowerStates[2],
+              highPass60, lowPass60);
+  LogOfEnergy(highPass60, half / 2, kOffsetVector[3], totalEnergy,
+              features[3]);
+  SplitFilter(lowPass60, half / 2, lanes.upperStates[3], lanes.lowerStates[3],
+              highPass120, lowPass120);
+  LogOfEnergy(highPass120, half / 4, kOffsetVector[2], totalEnergy,
+              features[2]);
+  SplitFilter(lowPass120, half / 4, lanes.upperStates[4], lanes.lowerStates[4],
+              highPass60, lowPass60);
+  LogOfEnergy(highPass60, half / 8, kOffsetVector[1], totalEnergy,
+              features[1]);
+
+  // remove 0 Hz - 80 Hz from the lowest band.
+  HighPassFilter(lowPass60, half / 8, lanes.highPassStates, highPass120);
+  LogOfEnergy(highPass120, half / 8, kOffsetVector[0], totalEnergy,
+              features[0]);
+}
+
+// WebRtcVad_GaussianProbability() on every lane, without branches. the
+// exponent is clamped so that it can be calculated for every lane, and then
+// discarded where it is too large.
+static ALWAYS_INLINE Lanes GaussianProbability(const Lanes& input,
+                                               const Lanes& mean,
+                                               const Lanes& std,
+                                               Lanes* delta) {
+  Lanes inverseStd = Wrap16(Divide(Splat(131072) + (std >> 1), std));
+  Lanes shifted = inverseStd >> 2;
+  Lanes inverseStd2 = Wrap16((shifted * shifted) >> 2);
+  Lanes difference = Wrap16(Wrap16(ShiftLeft(input, 3)) - mean);
+  *delta = Wrap16((inverseStd2 * difference) >> 10);
+  Lanes exponent = (*delta * difference) >> 9;
+
+  Lanes power = Wrap16(
+      (Splat(kLog2Exp) * Min(exponent, Splat(kCompVar - 1))) >> 12);
+  power = Wrap16(-power);
+  Lanes expValue = Splat(0x0400) | (power & Splat(0x03FF));
+  power = Wrap16(power ^ Splat(0xFFFF));
+  power = Wrap16((power >> 10) + Splat(1));
+  expValue = expValue >> power;
+  return inverseStd * Select(exponent < Splat(kCompVar), expValue, Splat(0));
+}
+
+// the quotient of WebRtcSpl_DivW32W16() rounded towards zero on both sides,
+// as vad_core.c does when updating the deviations.
+static ALWAYS_INLINE Lanes DivideSymmetric(const Lanes& numerator,
+                                           const Lanes& denominator) {
+  Lanes positive = numerator > Splat(0);
+  Lanes quotient =
+      Wrap16(Divide(Select(positive, numerator, -numerator), denominator));
+  return Select(positive, quotient, Wrap16(-quotient));
+}
+
+// WebRtcVad_FindMinimum() for a single lane. the smallest values are kept in
+// order, so the first one larger than the feature is where it's inserted.
+static int16_t FindMinimum(WebrtcVadLanes& lanes, int lane, int16_t feature,
+                           int channel) {
+  int offset = channel * 16;
+  int16_t ages[16];
+  int16_t values[16];
+  for (int i = 0; i < 16; i++) {
+    ages[i] = lanes.ages[offset + i][lane];
+    values[i] = lanes.smallestValues[offset + i][lane];
+  }
+
+  for (int i = 0; i < 16; i++) {
+    if (ages[i] != 100) {
+      ages[i]++;
+    } else {
+      for (int j = i; j < 15; j++) {
+        values[j] = values[j + 1];
+        ages[j] = ages[j + 1];
+      }
+
+      ages[15] = 101;
+      values[15] = 10000;
+    }
+  }
+
+  int position = 0;
+  while (position < 16 && feature >= values[position]) {
+    position++;
+  }
+
+  if (position < 16) {
+    for (int i = 15; i > position; i--) {
+      values[i] = values[i - 1];
+      ages[i] = ages[i - 1];
+    }
+
+    values[position] = feature;
+    ages[position] = 1;
   }
 
-  instance_ = WebRtcVad_Create();
-  WebRtcVad_Init(instance_);
-  WebRtcVad_set_mode(instance_, level_);
+  for (int i = 0; i < 16; i++) {
+    lanes.ages[offset + i][lane] = ages[i];
+    lanes.smallestValues[offset + i][lane] = values[i];
+  }
+
+  int32_t frames = lanes.frameCounters[lane];
+  int16_t& median = lanes.medians[channel][lane];
+  int16_t current = frames > 2 ? values[2] : frames > 0 ? values[0] : 1600;
+  int16_t alpha = 0;
+  if (frames > 0) {
+    alpha = current < median ? kSmoothingDown : kSmoothingUp;
+  }
+
+  int32_t smoothed = (alpha + 1) * median;
+  smoothed += (WEBRTC_SPL_WORD16_MAX - alpha) * current;
+  smoothed += 16384;
+  median = (int16_t)(smoothed >> 15);
+  return median;
+}
+
+// GmmProbability() from vad_core.c on every lane. every lane goes through
+// every step, and the model is only updated where the frame had enough
+// energy. writes the final decision of each lane, after hysteresis.
+static ALWAYS_INLINE void GmmProbability(WebrtcVadLanes& lanes,
+                                         int16_t (*features)[kLanes],
+                                         const int16_t* totalPower,
+                                         size_t size, bool* results) {
+  const Lanes zero = Splat(0);
+  const Lanes one = Splat(1);
+  int index = size == 80 ? 0 : size == 160 ? 1 : 2;
+  int16_t overhead1 = lanes.overHangMax1[index];
+  int16_t overhead2 = lanes.overHangMax2[index];
+  int16_t individualTest = lanes.individual[index];
+  int16_t totalTest = lanes.total[index];
+
+  // masks are -1 in the lanes where they hold.
+  Lanes active = Load(totalPower) > Splat(kMinEnergy);
+  Lanes vad = zero;
+  bool anyActive =
+      std::any_of(totalPower, totalPower + kLanes,
+                  [](int16_t power) { return power > kMinEnergy; });
+  if (anyActive) {
+    Lanes deltaN[kTableSize];
+    Lanes deltaS[kTableSize];
+    Lanes ngprvec[kTableSize];
+    Lanes sgprvec[kTableSize];
+    Lanes sumLogLikelihoodRatios = zero;
+    for (int channel = 0; channel < kNumChannels; channel++) {
+      int first = channel;
+      int second = channel + kNumChannels;
+      Lanes feature = Load(features[channel]);
+      Lanes noise0 = Splat(kNoiseDataWeights[first]) *
+                     GaussianProbability(feature, Load(lanes.noiseMeans[first]),
+                                         Load(lanes.noiseStds[first]),
+                                         &deltaN[first]);
+      Lanes noise1 =
+          Splat(kNoiseDataWeights[second]) *
+          GaussianProbability(feature, Load(lanes.noiseMeans[second]),
+                              Load(lanes.noiseStds[second]), &deltaN[second]);
+      Lanes speech0 =
+          Splat(kSpeechDataWeights[first]) *
+          GaussianProbability(feature, Load(lanes.speechMeans[first]),
+                              Load(lanes.speechStds[first]), &deltaS[first]);
+      Lanes speech1 =
+          Splat(kSpeechDataWeights[second]) *
+          GaussianProbability(feature, Load(lanes.speechMeans[second]),
+                              Load(lanes.speechStds[second]), &deltaS[second]);
+      Lanes h0Test = noise0 + noise1;
+      Lanes h1Test = speech0 + speech1;
+
+      Lanes shiftsH0 = Select(h0Test == zero, Splat(31), NormPositive(h0Test));
+      Lanes shiftsH1 = Select(h1Test == zero, Splat(31), NormPositive(h1Test));
+      Lanes logLikelihoodRatio = shiftsH0 - shiftsH1;
+      sumLogLikelihoodRatios =
+          sumLogLikelihoodRatios +
+          logLikelihoodRatio * Splat(kSpectrumWeight[channel]);
+      vad = vad | (ShiftLeft(logLikelihoodRatio, 2) > Splat(individualTest));
+
+      Lanes h0 = Wrap16(h0Test >> 12);
+      Lanes h0Positive = h0 > zero;
+      Lanes noiseShare = Wrap16(Divide(ShiftLeft(noise0 & Splat(-4096), 2),
+                                       Select(h0Positive, h0, one)));
+      ngprvec[first] = Select(h0Positive, noiseShare, Splat(16384));
+      ngprvec[second] =
+          Select(h0Positive, Wrap16(Splat(16384) - noiseShare), zero);
+
+      Lanes h1 = Wrap16(h1Test >> 12);
+      Lanes h1Positive = h1 > zero;
+      Lanes speechShare = Wrap16(Divide(ShiftLeft(speech0 & Splat(-4096), 2),
+                                        Select(h1Positive, h1, one)));
+      sgprvec[first] = Select(h1Positive, speechShare, zero);
+      sgprvec[second] =
+          Select(h1Positive, Wrap16(Splat(16384) - speechShare), zero);
+    }
+
+    vad = (vad | (sumLogLikelihoodRatios >= Splat(totalTest))) & active;
+    Lanes noise = active & ~vad;
+
+    int16_t maxspe = 12800;
+    for (int channel = 0; channel < kNumChannels; channel++) {
+      int16_t minimums[kLanes] = {0};
+      for (int lane = 0; lane < kLanes; lane++) {
+        if (totalPower[lane] > kMinEnergy) {
+          minimums[lane] =
+              FindMinimum(lanes, lane, features[channel][lane], channel);
+        }
+      }
+
+      Lanes feature = Load(features[channel]);
+      Lanes featureMinimum = Load(minimums);
+      Lanes noiseGlobalMean = Wrap16(
+          (Load(lanes.noiseMeans[channel]) * Splat(kNoiseDataWeights[channel]) +
+           Load(lanes.noiseMeans[channel + kNumChannels]) *
+               Splat(kNoiseDataWeights[channel + kNumChannels])) >>
+          6);
+
+      for (int k = 0; k < kNumGaussians; k++) {
+        int gaussian = channel + k * kNumChannels;
+        Lanes nmk = Load(lanes.noiseMeans[gaussian]);
+        Lanes smk = Load(lanes.speechMeans[gaussian]);
+        Lanes nsk = Load(lanes.noiseStds[gaussian]);
+        Lanes ssk = Load(lanes.speechStds[gaussian]);
+
+        // the noise means are updated for noise, and always corrected
+        // towards the long term minimum.
+        Lanes delt = Wrap16((ngprvec[gaussian] * deltaN[gaussian]) >> 11);
+        Lanes nmk2 = Select(
+            vad, nmk,
+            Wrap16(nmk + Wrap16((delt * Splat(kNoiseUpdateConst)) >> 22)));
+        Lanes ndelt = Wrap16(ShiftLeft(featureMinimum, 4) - noiseGlobalMean);
+        Lanes nmk3 = Wrap16(nmk2 + Wrap16((ndelt * Splat(kBackEta)) >> 9));
+        nmk3 = Min(Max(nmk3, Splat((k + 5) << 7)),
+                   Splat((72 + k - channel) << 7));
+
+        // the speech mean and deviation, for speech.
+        delt = Wrap16((sgprvec[gaussian] * deltaS[gaussian]) >> 11);
+        Lanes tmp = Wrap16((delt * Splat(kSpeechUpdateConst)) >> 21);
+        Lanes smk2 = Wrap16(smk + ((tmp + one) >> 1));
+        smk2 = Min(Max(smk2, Splat(kMinimumMean[k])), Splat(maxspe + 640));
+        tmp = Wrap16(feature - ((smk + Splat(4)) >> 3));
+        Lanes product = ((deltaS[gaussian] * tmp) >> 3) - Splat(4096);
+        product = WrappingMultiply(sgprvec[gaussian] >> 2, product) >> 4;
+        Lanes quotient = DivideSymmetric(product, Wrap16(ssk * Splat(10)));
+        quotient = Wrap16(quotient + Splat(128));
+        Lanes ssk2 = Max(Wrap16(ssk + (quotient >> 8)), Splat(kMinStd));
+
+        // the noise deviation, for noise.
+        tmp = Wrap16(feature - (nmk >> 3));
+        product = ((deltaN[gaussian] * tmp) >> 3) - Splat(4096);
+        product = WrappingMultiply(Wrap16((ngprvec[gaussian] + Splat(2)) >> 2),
+                                   product) >>
+                  14;
+        quotient = Wrap16(DivideSymmetric(product, nsk) + Splat(32));
+        Lanes nsk2 = Max(Wrap16(nsk + (quotient >> 6)), Splat(kMinStd));
+
+        Store(lanes.noiseMeans[gaussian], Select(active, nmk3, nmk));
+        Store(lanes.speechMeans[gaussian], Select(vad, smk2, smk));
+        Store(lanes.speechStds[gaussian], Select(vad, ssk2, ssk));
+        Store(lanes.noiseStds[gaussian], Select(noise, nsk2, nsk));
+      }
+
+      // separate the models if they are too close, and keep the means from
+      // drifting too far.
+      int first = channel;
+      int second = channel + kNumChannels;
+      const Lanes noiseWeight0 = Splat(kNoiseDataWeights[first]);
+      const Lanes noiseWeight1 = Splat(kNoiseDataWeights[second]);
+      const Lanes speechWeight0 = Splat(kSpeechDataWeights[first]);
+      const Lanes speechWeight1 = Splat(kSpeechDataWeights[second]);
+      Lanes oldNoise0 = Load(lanes.noiseMeans[first]);
+      Lanes oldNoise1 = Load(lanes.noiseMeans[second]);
+      Lanes oldSpeech0 = Load(lanes.speechMeans[first]);
+      Lanes oldSpeech1 = Load(lanes.speechMeans[second]);
+      Lanes noiseMean = oldNoise0 * noiseWeight0 + oldNoise1 * noiseWeight1;
+      Lanes speechMean =
+          oldSpeech0 * speechWeight0 + oldSpeech1 * speechWeight1;
+      Lanes diff = Wrap16(Wrap16(speechMean >> 9) - Wrap16(noiseMean >> 9));
+      Lanes minimumDifference = Splat(kMinimumDifference[channel]);
+      Lanes close = diff < minimumDifference;
+      Lanes tmp = Wrap16(minimumDifference - diff);
+      Lanes speechOffset = Select(close, Wrap16((Splat(13) * tmp) >> 2), zero);
+      Lanes noiseOffset = Select(close, Wrap16((Splat(3) * tmp) >> 2), zero);
+      Lanes speech0 = Wrap16(oldSpeech0 + speechOffset);
+      Lanes speech1 = Wrap16(oldSpeech1 + speechOffset);
+      Lanes noise0 = Wrap16(oldNoise0 - noiseOffset);
+      Lanes noise1 = Wrap16(oldNoise1 - noiseOffset);
+      speechMean = speech0 * speechWeight0 + speech1 * speechWeight1;
+      noiseMean = noise0 * noiseWeight0 + noise1 * noiseWeight1;
+
+      Lanes maximum = Splat(kMaximumSpeech[channel]);
+      Lanes excess = Wrap16(speechMean >> 7);
+      excess = Select(excess > maximum, Wrap16(excess - maximum), zero);
+      speech0 = Wrap16(speech0 - excess);
+      speech1 = Wrap16(speech1 - excess);
+
+      maximum = Splat(kMaximumNoise[channel]);
+      excess = Wrap16(noiseMean >> 7);
+      excess = Select(excess > maximum, Wrap16(excess - maximum), zero);
+      noise0 = Wrap16(noise0 - excess);
+      noise1 = Wrap16(noise1 - excess);
+
+      Store(lanes.noiseMeans[first], Select(active, noise0, oldNoise0));
+      Store(lanes.noiseMeans[second], Select(active, noise1, oldNoise1));
+      Store(lanes.speechMeans[first], Select(active, speech0, oldSpeech0));
+      Store(lanes.speechMeans[second], Select(active, speech1, oldSpeech1));
+
+      maxspe = kMaximumSpeech[channel];
+    }
+
+    Store(lanes.frameCounters, Load(lanes.frameCounters) + (active & one));
+  }
+
+  // smooth the decisions with hysteresis.
+  Lanes overHang = Load(lanes.overHangs);
+  Lanes speechFrames = Wrap16(Load(lanes.speechFrames) + one);
+  Lanes maxSpeechFrames = Splat(kMaxSpeechFrames);
+  Store(lanes.speechFrames,
+        Select(vad, Min(speechFrames, maxSpeechFrames), zero));
+  Store(lanes.overHangs,
+        Select(vad,
+               Select(speechFrames > maxSpeechFrames, Splat(overhead2),
+                      Splat(overhead1)),
+               overHang - ((overHang > zero) & one)));
+
+  // like vad_core.c, a frame that's only speech because of the overhang
+  // reports how much overhang was left.
+  Store(lanes.results,
+        Select(vad, one,
+               Select(overHang > zero, overHang + Splat(2), zero)));
+  for (int lane = 0; lane < kLanes; lane++) {
+    results[lane] = lanes.results[lane] != 0;
+  }
+}
+
+// WebRtcVad_Process() on every lane.
+static ALWAYS_INLINE void ProcessLanes(WebrtcVadLanes& lanes, int sampleRate,
+                                       const int16_t* const* frames,
+                                       size_t size, bool* results) {
+  int16_t wide[kMaxFrameSize][kLanes];
+  int16_t middle[kMaxFrameSize / 2][kLanes];
+  int16_t narrow[kMaxNarrowSize][kLanes];
+  const int16_t(*input)[kLanes] = narrow;
+  size_t narrowSize;
+  if (sampleRate == 48000) {
+    // like WebRtcVad_CalcVad48khz(), every 10ms block is resampled from the
+    // start of the frame.
+    narrowSize = size / 6;
+    for (int lane = 0; lane < kLanes; lane++) {
+      int16_t speech[kMaxNarrowSize];
+      int32_t scratch[480 + 256] = {0};
+      for (size_t i = 0; i < size / 480; i++) {
+        WebRtcSpl_Resample48khzTo8khz(frames[lane], &speech[i * 80],
+                                      &lanes.resamplerStates[lane], scratch);
+      }
+
+      for (size_t i = 0; i < narrowSize; i++) {
+        narrow[i][lane] = speech[i];
+      }
+    }
+  } else {
+    for (size_t i = 0; i < size; i++) {
+      for (int lane = 0; lane < kLanes; lane++) {
+        wide[i][lane] = frames[lane][i];
+      }
+    }
+
+    if (sampleRate == 32000) {
+      Downsampling(wide, middle, &lanes.downsamplingStates[2], size);
+      Downsampling(middle, narrow, &lanes.downsamplingStates[0], size / 2);
+      narrowSize = size / 4;
+    } else if (sampleRate == 16000) {
+      Downsampling(wide, narrow, &lanes.downsamplingStates[0], size);
+      narrowSize = size / 2;
+    } else {
+      input = wide;
+      narrowSize = size;
+    }
+  }
+
+  int16_t features[kNumChannels][kLanes];
+  int16_t totalPower[kLanes];
+  CalculateFeatures(lanes, input, narrowSize, features, totalPower);
+  GmmProbability(lanes, features, totalPower, narrowSize, results);
+}
+
+typedef void (*ProcessLanesFunction)(WebrtcVadLanes&, int,
+                                     const int16_t* const*, size_t, bool*);
+
+#ifdef SPEECHRECORDER_X86
+TARGET("avx2")
+static void ProcessLanesAvx2(WebrtcVadLanes& lanes, int sampleRate,
+                             const int16_t* const* frames, size_t size,
+                             bool* results) {
+  ProcessLanes(lanes, sampleRate, frames, size, results);
+}
+#endif
+
+static void ProcessLanesDefault(WebrtcVadLanes& lanes, int sampleRate,
+                                const int16_t* const* frames, size_t size,
+                                bool* results) {
+  ProcessLanes(lanes, sampleRate, frames, size, results);
+}
+
+static ProcessLanesFunction SelectProcessLanes() {
+#ifdef SPEECHRECORDER_X86
+  if (WebRtc_GetCPUInfo(kAVX2)) {
+    return ProcessLanesAvx2;
+  }
+#endif
+  return ProcessLanesDefault;
+}
+
+WebrtcVadBank::WebrtcVadBank(int streams, int level, int sampleRate)
+    : streams_(streams), level_(level), sampleRate_(sampleRate) {
+  WebRtcSpl_Init();
+  for (int i = 0; i < streams; i += kLanes) {
+    groups_.push_back(std::make_unique<WebrtcVadLanes>());
+  }
+
+  Reset();
+}
+
+WebrtcVadBank::~WebrtcVadBank() {}
+
+void WebrtcVadBank::Process(const int16_t* const* frames, size_t size,
+                            bool* results) {
+  static const ProcessLanesFunction function = SelectProcessLanes();
+  static const int16_t silence[kMaxFrameSize] = {0};
+  if (WebRtcVad_ValidRateAndFrameLength(sampleRate_, size) != 0) {
+    std::fill(results, results + streams_, false);
+    return;
+  }
+
+  // the lanes past the last stream are given silence, and their results are
+  // dropped.
+  for (size_t group = 0; group < groups_.size(); group++) {
+    const int16_t* groupFrames[kLanes];
+    bool groupResults[kLanes];
+    int first = (int)group * kLanes;
+    int count = std::min(streams_ - first, kLanes);
+    for (int lane = 0; lane < kLanes; lane++) {
+      groupFrames[lane] = lane < count ? frames[first + lane] : silence;
+    }
+
+    function(*groups_[group], sampleRate_, groupFrames, size, groupResults);
+    std::copy(groupResults, groupResults + count, results + first);
+  }
+}
+
+void WebrtcVadBank::Reset() {
+  VadInstT initial;
+  WebRtcVad_InitCore(&initial);
+  WebRtcVad_set_mode_core(&initial, level_);
+  for (auto& group : groups_) {
+    for (int lane = 0; lane < kLanes; lane++) {
+      StoreLane(*group, lane, initial);
+    }
+
+    memcpy(group->overHangMax1, initial.over_hang_max_1,
+           sizeof(group->overHangMax1));
+    memcpy(group->overHangMax2, initial.over_hang_max_2,
+           sizeof(group->overHangMax2));
+    memcpy(group->individual, initial.individual, sizeof(group->individual));
+    memcpy(group->total, initial.total, sizeof(group->total));
+  }
+}
+
+void WebrtcVadBank::Snapshot(int stream, WebrtcVadState& snapshot) const {
+  WebRtcVad_InitCore(&snapshot);
+  WebRtcVad_set_mode_core(&snapshot, level_);
+  LoadLane(*groups_[stream / kLanes], stream % kLanes, snapshot);
+}
+
+void WebrtcVadBank::Restore(int stream, const WebrtcVadState& snapshot) {
+  StoreLane(*groups_[stream / kLanes], stream % kLanes, snapshot);
 }
 
 }  // namespace speechrecorder
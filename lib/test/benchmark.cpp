@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "frame_ring.h"
+#include "frame_statistics.h"
+#include "microphone.h"
+#include "resampler.h"
+#include "silero_vad.h"
+#include "webrtcvad.h"
+#include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
+
+extern "C" {
+#include "webrtc/common_audio/vad/vad_core.h"
+#include "webrtc/common_audio/vad/vad_filterbank.h"
+}
+
+using namespace speechrecorder;
+
+// compares the speed of the vectorized frame statistics and the scalar
+// version.
+static void BenchmarkFrameStatistics(int iterations) {
+  size_t size = 480;
+  std::vector<short> frame(size);
+  std::vector<float> output(size);
+  for (size_t i = 0; i < size; i++) {
+    frame[i] = (short)(rand() % 65536 - 32768);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations * 100; i++) {
+    AnalyzeFrameScalar(frame.data(), output.data(), size);
+  }
+
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "Scalar frame statistics: " << elapsed.count() / iterations / 100
+            << " us/frame" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations * 100; i++) {
+    AnalyzeFrame(frame.data(), output.data(), size);
+  }
+
+  elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "Vectorized frame statistics: "
+            << elapsed.count() / iterations / 100 << " us/frame" << std::endl;
+}
+
+// compares the speed of the c and the dispatched cross correlation.
+static void BenchmarkSignalProcessing(int iterations) {
+  WebRtcSpl_Init();
+
+  size_t size = 480;
+  std::vector<int16_t> first(size * 2);
+  std::vector<int16_t> second(size * 2);
+  std::vector<int32_t> expected(32);
+  std::vector<int32_t> actual(32);
+  for (size_t j = 0; j < first.size(); j++) {
+    first[j] = (int16_t)(rand() % 65536 - 32768);
+    second[j] = (int16_t)(rand() % 65536 - 32768);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations * 100; i++) {
+    WebRtcSpl_CrossCorrelationC(expected.data(), first.data(), second.data(),
+                                size, expected.size(), 0, 1);
+  }
+
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "C cross correlation: " << elapsed.count() / iterations / 100
+            << " us/frame" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations * 100; i++) {
+    WebRtcSpl_CrossCorrelation(actual.data(), first.data(), second.data(),
+                               size, actual.size(), 0, 1);
+  }
+
+  elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "Dispatched cross correlation: "
+            << elapsed.count() / iterations / 100 << " us/frame" << std::endl;
+}
+
+// compares the speed of the vectorized vad filterbank and the c version.
+static void BenchmarkVadFeatures(int iterations) {
+  VadInstT state;
+  WebRtcVad_InitCore(&state);
+  std::vector<int16_t> frame(240);
+  int16_t features[kNumChannels];
+  for (size_t i = 0; i < frame.size(); i++) {
+    frame[i] = (int16_t)(rand() % 2000 - 1000);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations * 100; i++) {
+    WebRtcVad_CalculateFeaturesC(&state, frame.data(), frame.size(),
+                                 features);
+  }
+
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "C VAD features: " << elapsed.count() / iterations / 100
+            << " us/frame" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations * 100; i++) {
+    WebRtcVad_CalculateFeatures(&state, frame.data(), frame.size(), features);
+  }
+
+  elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "Vectorized VAD features: "
+            << elapsed.count() / iterations / 100 << " us/frame" << std::endl;
+}
+
+// compares the speed of the vad bank and a separate vad for each stream.
+static void BenchmarkVadBank(int iterations) {
+  int streams = 256;
+  size_t size = 160;
+  WebrtcVadBank bank(streams, 3, 16000);
+  std::vector<std::unique_ptr<WebrtcVad>> vads;
+  std::vector<std::vector<int16_t>> frames(streams, std::vector<int16_t>(size));
+  std::vector<const int16_t*> pointers;
+  for (int i = 0; i < streams; i++) {
+    vads.push_back(std::make_unique<WebrtcVad>(3, 16000));
+    for (size_t j = 0; j < size; j++) {
+      frames[i][j] = (int16_t)(rand() % 2000 - 1000);
+    }
+    pointers.push_back(frames[i].data());
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    for (int j = 0; j < streams; j++) {
+      vads[j]->Process(frames[j].data(), size);
+    }
+  }
+
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "Separate VADs: " << elapsed.count() / iterations / streams
+            << " us/stream/frame" << std::endl;
+
+  std::unique_ptr<bool[]> results(new bool[streams]);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    bank.Process(pointers.data(), size, results.get());
+  }
+
+  elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "VAD bank: " << elapsed.count() / iterations / streams
+            << " us/stream/frame" << std::endl;
+}
+
+// runs the microphone callback the way portaudio would, with and without
+// resampling.
+static void BenchmarkCaptureCallback(int iterations) {
+  int samplesPerFrame = 480;
+  int sampleRate = 16000;
+  for (int captureSampleRate : {16000, 48000, 44100}) {
+    unsigned long framesPerBuffer =
+        (unsigned long)(samplesPerFrame * captureSampleRate / sampleRate);
+    FrameRing ring(samplesPerFrame, 10);
+    std::unique_ptr<Resampler> resampler;
+    std::vector<short> resampled;
+    MicrophoneCallbackData data;
+    data.ring = &ring;
+    if (captureSampleRate != sampleRate) {
+      resampler = std::make_unique<Resampler>(captureSampleRate, sampleRate);
+      resampler->Reserve(framesPerBuffer);
+      resampled.reserve(samplesPerFrame * 4);
+      data.resampler = resampler.get();
+      data.resampled = &resampled;
+    }
+
+    std::vector<short> input(framesPerBuffer);
+    for (size_t i = 0; i < input.size(); i++) {
+      input[i] = (short)(rand() % 2000 - 1000);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      callback(input.data(), nullptr, framesPerBuffer, nullptr, 0, &data);
+      while (ring.Read() != nullptr) {
+        ring.Release();
+      }
+    }
+
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "Capture callback at " << captureSampleRate
+              << " Hz: " << elapsed.count() / iterations << " us/callback"
+              << std::endl;
+  }
+}
+
+// times the hot paths. the checks that they're exact are in test.cpp. with a
+// model, this also compares per-call silero latency, building tensors on every
+// call (as ChunkProcessor used to) versus running a SileroVad with
+// preallocated bindings.
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+  if (iterations <= 0) {
+    std::cout << "Usage: benchmark [iterations] [/path/to/vad.onnx]"
+              << std::endl;
+    return 1;
+  }
+
+  BenchmarkFrameStatistics(iterations);
+  BenchmarkSignalProcessing(iterations);
+  BenchmarkVadFeatures(iterations);
+  BenchmarkVadBank(iterations);
+  BenchmarkCaptureCallback(iterations);
+  if (argc < 3) {
+    return 0;
+  }
+
+  int sampleRate = 16000;
+  size_t windowSize = 2000;
+  Ort::Session& session = AcquireSileroVadSession(argv[2]);
+  SileroVad vad(session, sampleRate, windowSize);
+  std::vector<float> audio(vad.InputSize());
+  for (size_t i = 0; i < audio.size(); i++) {
+    audio[i] = (float)(rand() % 2000 - 1000) / 32767.0f;
+  }
+
+  if (vad.Version() == SileroVadVersion::V3) {
+    Ort::MemoryInfo memory = Ort::MemoryInfo::CreateCpu(
+        OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      std::vector<int64_t> inputDimensions{1, (int64_t)audio.size()};
+      std::vector<Ort::Value> inputTensors;
+      inputTensors.push_back(Ort::Value::CreateTensor<float>(
+          memory, audio.data(), audio.size(), inputDimensions.data(),
+          inputDimensions.size()));
+
+      std::vector<float> outputTensorValues(2);
+      std::vector<int64_t> outputDimensions{1, 2};
+      std::vector<Ort::Value> outputTensors;
+      outputTensors.push_back(Ort::Value::CreateTensor<float>(
+          memory, outputTensorValues.data(), outputTensorValues.size(),
+          outputDimensions.data(), outputDimensions.size()));
+
+      std::vector<const char*> inputNames{"input"};
+      std::vector<const char*> outputNames{"output"};
+      session.Run(Ort::RunOptions{nullptr}, inputNames.data(),
+                  inputTensors.data(), 1, outputNames.data(),
+                  outputTensors.data(), 1);
+    }
+
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "Per-call tensors: " << elapsed.count() / iterations
+              << " us/call" << std::endl;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    vad.Process(audio.data());
+  }
+
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "Bound tensors: " << elapsed.count() / iterations << " us/call"
+            << std::endl;
+}
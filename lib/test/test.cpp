@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame_ring.h"
+#include "frame_statistics.h"
+#include "microphone.h"
+#include "resampler.h"
+#include "webrtcvad.h"
+#include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+extern "C" {
+#include "webrtc/common_audio/vad/vad_core.h"
+#include "webrtc/common_audio/vad/vad_filterbank.h"
+}
+
+using namespace speechrecorder;
+
+// the exit code ctest treats as a skipped test.
+static const int kSkipped = 77;
+
+// every check prints what differs and exits with 1.
+static void Fail(const std::string& message) {
+  std::cout << message << std::endl;
+  exit(1);
+}
+
+// the most capable instruction set the dispatched functions may use, or -1
+// for plain c. everything that dispatches at runtime asks WebRtc_GetCPUInfo,
+// so replacing it before the first dispatch forces every version in turn.
+static int maximumFeature = INT_MAX;
+static WebRtc_CPUInfo detectedCPUInfo = nullptr;
+
+static int LimitedCPUInfo(CPUFeature feature) {
+  return (int)feature <= maximumFeature && detectedCPUInfo(feature);
+}
+
+// checks the dispatched frame statistics against the scalar version.
+static void CheckFrameStatistics() {
+  size_t size = 480;
+  std::vector<short> frame(size);
+  std::vector<float> expected(size);
+  std::vector<float> actual(size);
+  for (int i = 0; i < 100; i++) {
+    for (size_t j = 0; j < size; j++) {
+      frame[j] = i == 0 ? SHRT_MIN : (short)(rand() % 65536 - 32768);
+    }
+
+    // vary the length too, so that every remainder is covered.
+    size_t length = size - i;
+    FrameStatistics scalar =
+        AnalyzeFrameScalar(frame.data(), expected.data(), length);
+    FrameStatistics vectorized =
+        AnalyzeFrame(frame.data(), actual.data(), length);
+    if (scalar.sumOfSquares != vectorized.sumOfSquares ||
+        scalar.peak != vectorized.peak ||
+        scalar.zeroCrossings != vectorized.zeroCrossings ||
+        memcmp(expected.data(), actual.data(), length * sizeof(float)) != 0) {
+      Fail("Frame statistics differ for length " + std::to_string(length));
+    }
+  }
+}
+
+static int32_t RandomW32() {
+  return (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+}
+
+// checks that webrtc dispatched the version for the instruction set, and that
+// every dispatched function matches its c version. lengths, shifts, and filter
+// sizes are varied, so that every remainder is covered.
+static void CheckSignalProcessing() {
+  WebRtcSpl_Init();
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  CrossCorrelation version = WebRtcSpl_CrossCorrelationC;
+  if (WebRtc_GetCPUInfo(kAVX2)) {
+    version = WebRtcSpl_CrossCorrelationAvx2;
+  } else if (WebRtc_GetCPUInfo(kSSE4_1)) {
+    version = WebRtcSpl_CrossCorrelationSse41;
+  }
+
+  if (WebRtcSpl_CrossCorrelation != version) {
+    Fail("Signal processing dispatched the wrong version");
+  }
+#endif
+
+  size_t size = 480;
+  size_t history = 64;
+  std::vector<int16_t> first(size * 2);
+  std::vector<int16_t> second(size * 2);
+  std::vector<int32_t> wide(size);
+  std::vector<int16_t> coefficients(40);
+  std::vector<int32_t> expected(32);
+  std::vector<int32_t> actual(32);
+  std::vector<int16_t> expectedOutput(size);
+  std::vector<int16_t> actualOutput(size);
+  for (int i = 0; i < 200; i++) {
+    for (size_t j = 0; j < first.size(); j++) {
+      first[j] = i == 0 ? SHRT_MIN : (int16_t)(rand() % 65536 - 32768);
+      second[j] = (int16_t)(rand() % 65536 - 32768);
+    }
+
+    // the c version of MaxAbsValueW32 takes abs(INT_MIN), which is
+    // undefined, so INT_MIN is left out.
+    for (size_t j = 0; j < wide.size(); j++) {
+      wide[j] = i == 0 ? INT_MIN + 1 : std::max(RandomW32(), INT_MIN + 1);
+    }
+
+    // coefficients are in Q12, and kept small enough that the c version's
+    // sums can't overflow.
+    for (size_t j = 0; j < coefficients.size(); j++) {
+      coefficients[j] = (int16_t)(rand() % 2048 - 1024);
+    }
+
+    size_t length = size - i;
+    int shift = i % 16;
+    bool same = WebRtcSpl_MaxAbsValueW16C(first.data(), length) ==
+                    WebRtcSpl_MaxAbsValueW16(first.data(), length) &&
+                WebRtcSpl_MaxAbsValueW32C(wide.data(), length) ==
+                    WebRtcSpl_MaxAbsValueW32(wide.data(), length) &&
+                WebRtcSpl_MaxValueW16C(first.data(), length) ==
+                    WebRtcSpl_MaxValueW16(first.data(), length) &&
+                WebRtcSpl_MaxValueW32C(wide.data(), length) ==
+                    WebRtcSpl_MaxValueW32(wide.data(), length) &&
+                WebRtcSpl_MinValueW16C(first.data(), length) ==
+                    WebRtcSpl_MinValueW16(first.data(), length) &&
+                WebRtcSpl_MinValueW32C(wide.data(), length) ==
+                    WebRtcSpl_MinValueW32(wide.data(), length);
+
+    // the second sequence steps backwards as well as forwards, so it starts
+    // far enough in to stay inside the buffer.
+    for (int step = -1; step <= 1 && same; step += 2) {
+      const int16_t* seq2 = second.data() + (step < 0 ? expected.size() : 0);
+      WebRtcSpl_CrossCorrelationC(expected.data(), first.data(), seq2, length,
+                                  expected.size(), shift, step);
+      WebRtcSpl_CrossCorrelation(actual.data(), first.data(), seq2, length,
+                                 actual.size(), shift, step);
+      same = expected == actual;
+    }
+
+    // the filter reads up to coefficients - 1 samples before its input.
+    size_t count = 1 + i % coefficients.size();
+    int factor = 1 + i % 4;
+    size_t delay = i % 3;
+    size_t outputLength = (length - 1 - delay) / factor + 1;
+    std::fill(expectedOutput.begin(), expectedOutput.end(), 0);
+    std::fill(actualOutput.begin(), actualOutput.end(), 0);
+    same = same &&
+           WebRtcSpl_DownsampleFastC(first.data() + history, length,
+                                     expectedOutput.data(), outputLength,
+                                     coefficients.data(), count, factor,
+                                     delay) ==
+               WebRtcSpl_DownsampleFast(first.data() + history, length,
+                                        actualOutput.data(), outputLength,
+                                        coefficients.data(), count, factor,
+                                        delay) &&
+           expectedOutput == actualOutput;
+
+    int16_t firstScale = (int16_t)(rand() % 32767 - 16383);
+    int16_t secondScale = (int16_t)(rand() % 32767 - 16383);
+    same = same &&
+           WebRtcSpl_ScaleAndAddVectorsWithRoundC(
+               first.data(), firstScale, second.data(), secondScale, shift,
+               expectedOutput.data(), length) ==
+               WebRtcSpl_ScaleAndAddVectorsWithRound(
+                   first.data(), firstScale, second.data(), secondScale,
+                   shift, actualOutput.data(), length) &&
+           expectedOutput == actualOutput;
+
+    if (!same) {
+      Fail("Signal processing differs for length " + std::to_string(length));
+    }
+  }
+}
+
+// runs the vectorized vad filterbank and the c version over the same audio,
+// checking that the features and filter states stay identical.
+static void CheckVadFeatures() {
+  VadInstT expectedState;
+  VadInstT actualState;
+  WebRtcVad_InitCore(&expectedState);
+  WebRtcVad_InitCore(&actualState);
+
+  // a mix of silence, quiet and loud tones, noise, and clipping, in each of
+  // the frame sizes the vad supports.
+  const int amplitudes[] = {0, 3, 300, 8000, 32767};
+  std::vector<std::vector<int16_t>> frames;
+  for (int i = 0; i < 300; i++) {
+    std::vector<int16_t> frame(80 * (i % 3 + 1));
+    int amplitude = amplitudes[i / 3 % 5];
+    for (size_t j = 0; j < frame.size(); j++) {
+      int noise = i % 2 == 0 ? rand() % 21 - 10 : rand() % 65536 - 32768;
+      int value = (int)(amplitude * sin(0.05 * (i % 7 + 1) * j)) + noise;
+      frame[j] = (int16_t)std::min(std::max(value, SHRT_MIN), SHRT_MAX);
+    }
+
+    frames.push_back(frame);
+  }
+
+  for (int i = 0; i < 100; i++) {
+    for (auto& frame : frames) {
+      int16_t expected[kNumChannels];
+      int16_t actual[kNumChannels];
+      int16_t expectedEnergy = WebRtcVad_CalculateFeaturesC(
+          &expectedState, frame.data(), frame.size(), expected);
+      int16_t actualEnergy = WebRtcVad_CalculateFeatures(
+          &actualState, frame.data(), frame.size(), actual);
+      if (expectedEnergy != actualEnergy ||
+          memcmp(expected, actual, sizeof(expected)) != 0 ||
+          memcmp(expectedState.upper_state, actualState.upper_state,
+                 sizeof(expectedState.upper_state)) != 0 ||
+          memcmp(expectedState.lower_state, actualState.lower_state,
+                 sizeof(expectedState.lower_state)) != 0 ||
+          memcmp(expectedState.hp_filter_state, actualState.hp_filter_state,
+                 sizeof(expectedState.hp_filter_state)) != 0) {
+        Fail("VAD features differ for a frame of " +
+             std::to_string(frame.size()) + " samples");
+      }
+    }
+  }
+}
+
+template <typename T, size_t N>
+static bool SameArray(const T (&expected)[N], const T (&actual)[N]) {
+  return std::equal(expected, expected + N, actual);
+}
+
+// compares every field of two vad states.
+static bool SameVadState(const VadInstT& expected, const VadInstT& actual) {
+  const WebRtcSpl_State48khzTo8khz& expected48 = expected.state_48_to_8;
+  const WebRtcSpl_State48khzTo8khz& actual48 = actual.state_48_to_8;
+  return expected.vad == actual.vad &&
+         SameArray(expected.downsampling_filter_states,
+                   actual.downsampling_filter_states) &&
+         SameArray(expected48.S_48_24, actual48.S_48_24) &&
+         SameArray(expected48.S_24_24, actual48.S_24_24) &&
+         SameArray(expected48.S_24_16, actual48.S_24_16) &&
+         SameArray(expected48.S_16_8, actual48.S_16_8) &&
+         SameArray(expected.noise_means, actual.noise_means) &&
+         SameArray(expected.speech_means, actual.speech_means) &&
+         SameArray(expected.noise_stds, actual.noise_stds) &&
+         SameArray(expected.speech_stds, actual.speech_stds) &&
+         expected.frame_counter == actual.frame_counter &&
+         expected.over_hang == actual.over_hang &&
+         expected.num_of_speech == actual.num_of_speech &&
+         SameArray(expected.index_vector, actual.index_vector) &&
+         SameArray(expected.low_value_vector, actual.low_value_vector) &&
+         SameArray(expected.mean_value, actual.mean_value) &&
+         SameArray(expected.upper_state, actual.upper_state) &&
+         SameArray(expected.lower_state, actual.lower_state) &&
+         SameArray(expected.hp_filter_state, actual.hp_filter_state) &&
+         SameArray(expected.over_hang_max_1, actual.over_hang_max_1) &&
+         SameArray(expected.over_hang_max_2, actual.over_hang_max_2) &&
+         SameArray(expected.individual, actual.individual) &&
+         SameArray(expected.total, actual.total) &&
+         expected.init_flag == actual.init_flag;
+}
+
+// checks the vad bank against a separate vad for each stream, on streams that
+// switch between silence, tones, and noise at different times, including
+// after states have been swapped between them. the whole state of every
+// stream has to match after every frame, not just the decisions.
+static void CheckVadBank() {
+  int streams = 13;
+  for (int sampleRate : {8000, 16000, 32000, 48000}) {
+    for (size_t milliseconds : {10, 20, 30}) {
+      std::string name = std::to_string(sampleRate) + " Hz with " +
+                         std::to_string(milliseconds) + " ms frames";
+      size_t size = sampleRate / 1000 * milliseconds;
+      WebrtcVadBank bank(streams, 3, sampleRate);
+      std::vector<std::unique_ptr<WebrtcVad>> vads;
+      std::vector<std::vector<int16_t>> frames(streams,
+                                               std::vector<int16_t>(size));
+      std::vector<const int16_t*> pointers;
+      for (int i = 0; i < streams; i++) {
+        vads.push_back(std::make_unique<WebrtcVad>(3, sampleRate));
+        pointers.push_back(frames[i].data());
+      }
+
+      for (int i = 0; i < 300; i++) {
+        for (int j = 0; j < streams; j++) {
+          double amplitude = (i / (7 + j)) % 3 == 0 ? 0 : 1000 * ((i / 13) % 4);
+          for (size_t k = 0; k < size; k++) {
+            double time = (double)(i * size + k) / sampleRate;
+            double value = amplitude * sin(2 * M_PI * (150 + 40 * j) * time) +
+                           (rand() % 41 - 20) * (j % 3);
+            frames[j][k] = (int16_t)value;
+          }
+        }
+
+        // moving a stream's state between the bank and a separate vad
+        // shouldn't change anything.
+        WebrtcVadState expected;
+        WebrtcVadState actual;
+        if (i == 150) {
+          vads[0]->Snapshot(expected);
+          bank.Restore(1, expected);
+          vads[1]->Restore(expected);
+          bank.Snapshot(2, expected);
+          vads[2]->Restore(expected);
+        }
+
+        bool results[16];
+        bank.Process(pointers.data(), size, results);
+        for (int j = 0; j < streams; j++) {
+          if (vads[j]->Process(frames[j].data(), size) != results[j]) {
+            Fail("VAD bank decisions differ at " + name);
+          }
+
+          vads[j]->Snapshot(expected);
+          bank.Snapshot(j, actual);
+          if (!SameVadState(expected, actual)) {
+            Fail("VAD bank state differs at " + name);
+          }
+        }
+      }
+    }
+  }
+}
+
+// runs the microphone callback the way portaudio would, with and without
+// resampling, and checks that every frame makes it through the ring. when
+// built with SPEECHRECORDER_REALTIME_CHECKS, this aborts if the callback
+// allocates.
+static void CheckCaptureCallback() {
+  int samplesPerFrame = 480;
+  int sampleRate = 16000;
+  int callbacks = 1000;
+  for (int captureSampleRate : {16000, 48000, 44100}) {
+    unsigned long framesPerBuffer =
+        (unsigned long)(samplesPerFrame * captureSampleRate / sampleRate);
+    FrameRing ring(samplesPerFrame, 10);
+    std::unique_ptr<Resampler> resampler;
+    std::vector<short> resampled;
+    MicrophoneCallbackData data;
+    data.ring = &ring;
+    if (captureSampleRate != sampleRate) {
+      resampler = std::make_unique<Resampler>(captureSampleRate, sampleRate);
+      resampler->Reserve(framesPerBuffer);
+      resampled.reserve(samplesPerFrame * 4);
+      data.resampler = resampler.get();
+      data.resampled = &resampled;
+    }
+
+    std::vector<short> input(framesPerBuffer);
+    for (size_t i = 0; i < input.size(); i++) {
+      input[i] = (short)(rand() % 2000 - 1000);
+    }
+
+    uint64_t frames = 0;
+    for (int i = 0; i < callbacks; i++) {
+      callback(input.data(), nullptr, framesPerBuffer, nullptr, 0, &data);
+      while (ring.Read() != nullptr) {
+        ring.Release();
+        frames++;
+      }
+    }
+
+    FrameRingStats stats = ring.Stats();
+    if (stats.overruns != 0 || stats.frames != frames ||
+        frames + 2 < (uint64_t)callbacks) {
+      Fail("Capture callback at " + std::to_string(captureSampleRate) +
+           " Hz lost frames");
+    }
+  }
+}
+
+// runs every check that doesn't need a model. given an instruction set (c,
+// sse2, sse4.1, or avx2), every dispatched function is limited to it, and the
+// run is skipped if the cpu doesn't support it.
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    std::string name = argv[1];
+    if (name == "c") {
+      maximumFeature = -1;
+    } else if (name == "sse2") {
+      maximumFeature = kSSE2;
+    } else if (name == "sse4.1") {
+      maximumFeature = kSSE4_1;
+    } else if (name == "avx2") {
+      maximumFeature = kAVX2;
+    } else {
+      std::cout << "Usage: tests [c|sse2|sse4.1|avx2]" << std::endl;
+      return 1;
+    }
+
+    if (maximumFeature >= 0 &&
+        !WebRtc_GetCPUInfo((CPUFeature)maximumFeature)) {
+      std::cout << "This CPU doesn't support " << name << std::endl;
+      return kSkipped;
+    }
+
+    detectedCPUInfo = WebRtc_GetCPUInfo;
+    WebRtc_GetCPUInfo = LimitedCPUInfo;
+  }
+
+  CheckFrameStatistics();
+  CheckSignalProcessing();
+  CheckVadFeatures();
+  CheckVadBank();
+  CheckCaptureCallback();
+  std::cout << "All checks passed" << std::endl;
+  return 0;
+}
@@ -4,11 +4,22 @@ const { SpeechRecorder, devices } = require("bindings")("speechrecorder.node");
 class Wrapper {
   constructor(options, model) {
     options = options ? options : {};
+    options.batchFrames = options.batchFrames !== undefined ? options.batchFrames : 1;
+    options.batchLatency = options.batchLatency !== undefined ? options.batchLatency : 0;
+    options.captureBufferFrames =
+      options.captureBufferFrames !== undefined ? options.captureBufferFrames : 10;
+    options.captureOverflow =
+      options.captureOverflow !== undefined ? options.captureOverflow : "dropOldest";
+    options.captureSampleRate =
+      options.captureSampleRate !== undefined ? options.captureSampleRate : 0;
     options.consecutiveFramesForSilence =
       options.consecutiveFramesForSilence !== undefined ? options.consecutiveFramesForSilence : 10;
     options.consecutiveFramesForSpeaking =
       options.consecutiveFramesForSpeaking !== undefined ? options.consecutiveFramesForSpeaking : 1;
     options.device = options.device !== undefined ? options.device : -1;
+    options.devices = options.devices !== undefined ? options.devices : [];
+    options.externalBuffers =
+      options.externalBuffers !== undefined ? options.externalBuffers : false;
     options.leadingBufferFrames =
       options.leadingBufferFrames !== undefined ? options.leadingBufferFrames : 10;
     options.onChunkStart = options.onChunkStart !== undefined ? options.onChunkStart : (data) => {};
@@ -17,12 +28,20 @@ class Wrapper {
         ? options.onAudio
         : (audio, speaking, volume, speech, probability) => {};
     options.onChunkEnd = options.onChunkEnd !== undefined ? options.onChunkEnd : (data) => {};
+    options.replayFile = options.replayFile !== undefined ? options.replayFile : "";
+    options.replaySpeed = options.replaySpeed !== undefined ? options.replaySpeed : 1;
     options.samplesPerFrame = options.samplesPerFrame !== undefined ? options.samplesPerFrame : 480;
     options.sampleRate = options.sampleRate !== undefined ? options.sampleRate : 16000;
+    options.sileroVadBatchSize =
+      options.sileroVadBatchSize !== undefined ? options.sileroVadBatchSize : 32;
+    options.sileroVadBatchWindow =
+      options.sileroVadBatchWindow !== undefined ? options.sileroVadBatchWindow : 0;
     options.sileroVadBufferSize =
       options.sileroVadBufferSize !== undefined ? options.sileroVadBufferSize : 2000;
     options.sileroVadRateLimit =
       options.sileroVadRateLimit !== undefined ? options.sileroVadRateLimit : 3;
+    options.sileroVadSessions =
+      options.sileroVadSessions !== undefined ? options.sileroVadSessions : 1;
     options.sileroVadSilenceThreshold =
       options.sileroVadSilenceThreshold !== undefined ? options.sileroVadSilenceThreshold : 0.1;
     options.sileroVadSpeakingThreshold =
@@ -33,36 +52,87 @@ class Wrapper {
     options.webrtcVadResultsSize =
       options.webrtcVadResultsSize !== undefined ? options.webrtcVadResultsSize : 10;
 
+    this.sampleRate = options.sampleRate;
     this.inner = new SpeechRecorder(
       model !== undefined ? model : path.join(__dirname, "..", "lib", "resources", "vad.onnx"),
       (event, data) => {
         if (event == "chunkStart") {
-          options.onChunkStart({ audio: data.audio });
+          options.onChunkStart({ audio: data.audio, device: data.device });
         } else if (event == "audio") {
           options.onAudio({
             audio: data.audio,
+            device: data.device,
             speaking: data.speaking,
             probability: data.probability,
             volume: data.volume,
             speech: data.speech,
             consecutiveSilence: data.consecutiveSilence,
           });
+        } else if (event == "audioBatch") {
+          if (options.onAudioBatch !== undefined) {
+            options.onAudioBatch(data);
+          } else {
+            const samples = data.audio.length / data.frames;
+            for (let i = 0; i < data.frames; i++) {
+              options.onAudio({
+                audio: data.audio.subarray(i * samples, (i + 1) * samples),
+                device: data.device,
+                speaking: data.speaking[i] == 1,
+                probability: data.probability[i],
+                volume: data.volume[i],
+                speech: data.speech[i] == 1,
+                consecutiveSilence: data.consecutiveSilence[i],
+              });
+            }
+          }
         } else if (event == "chunkEnd") {
-          options.onChunkEnd();
+          options.onChunkEnd({ device: data.device });
         }
       },
       options
     );
   }
 
+  processBuffer(audio, sampleRate, channels) {
+    this.inner.processBuffer(
+      audio,
+      sampleRate !== undefined ? sampleRate : this.sampleRate,
+      channels !== undefined ? channels : 1
+    );
+  }
+
   processFile(file) {
     this.inner.processFile(path.resolve(file));
   }
 
+  processFileAsync(file) {
+    return this.inner.processFileAsync(path.resolve(file));
+  }
+
+  processFiles(files, options) {
+    options = options ? options : {};
+    return this.inner.processFiles(
+      files.map((file) => path.resolve(file)),
+      options.concurrency !== undefined ? options.concurrency : 0
+    );
+  }
+
+  push(audio, sampleRate, channels) {
+    this.inner.push(
+      audio,
+      sampleRate !== undefined ? sampleRate : this.sampleRate,
+      channels !== undefined ? channels : 1
+    );
+  }
+
   start() {
     this.inner.start();
   }
 
+  stats() {
+    return this.inner.stats();
+  }
+
   stop() {
     this.inner.stop();
   }
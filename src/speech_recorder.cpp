@@ -1,29 +1,142 @@
 #include <napi.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <climits>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "chunk_processor.h"
 #include "devices.h"
+#include "microphone.h"
 #include "portaudio.h"
+#include "replay_source.h"
+#include "resampler.h"
 #include "speech_recorder.h"
+#include "wav_reader.h"
 
-#define DR_WAV_IMPLEMENTATION
-#include "dr_wav.h"
+static Napi::Int16Array CopyAudio(Napi::Env env, const short* audio,
+                                  size_t size) {
+  Napi::Int16Array result = Napi::Int16Array::New(env, size);
+  std::memcpy(result.Data(), audio, size * sizeof(short));
+  return result;
+}
+
+// callback data objects are recycled through the pool, and the audio vector
+// keeps its capacity across uses, so steady-state events don't allocate.
+static void SetEventCallbacks(
+    speechrecorder::ChunkProcessorOptions& options,
+    speechrecorder::Pool<SpeechRecorderCallbackData>* pool, int device,
+    std::function<void(SpeechRecorderCallbackData*)> emit) {
+  options.onChunkStartView = [pool, device,
+                              emit](speechrecorder::Span<const short> audio) {
+    SpeechRecorderCallbackData* data = pool->Acquire();
+    data->event = "chunkStart";
+    data->device = device;
+    data->audio.assign(audio.begin(), audio.end());
+    data->speaking = false;
+    data->volume = 0.0;
+    data->speech = false;
+    data->probability = 0.0;
+    data->consecutiveSilence = 0;
+    emit(data);
+  };
+
+  options.onAudioView = [pool, device, emit](
+                            speechrecorder::Span<const short> audio,
+                            bool speaking, double volume, bool speech,
+                            double probability, int consecutiveSilence) {
+    SpeechRecorderCallbackData* data = pool->Acquire();
+    data->event = "audio";
+    data->device = device;
+    data->audio.assign(audio.begin(), audio.end());
+    data->speaking = speaking;
+    data->volume = volume;
+    data->speech = speech;
+    data->probability = probability;
+    data->consecutiveSilence = consecutiveSilence;
+    emit(data);
+  };
+
+  options.onChunkEnd = [pool, device, emit]() {
+    SpeechRecorderCallbackData* data = pool->Acquire();
+    data->event = "chunkEnd";
+    data->device = device;
+    data->audio.clear();
+    data->speaking = false;
+    data->volume = 0.0;
+    data->speech = false;
+    data->probability = 0.0;
+    data->consecutiveSilence = 0;
+    emit(data);
+  };
+}
+
+// feeds every complete frame of a wav file to the processor, resampling it
+// first if the file isn't at the processor's sample rate.
+static bool ReadFile(speechrecorder::ChunkProcessor& processor,
+                     const std::string& path, int samplesPerFrame) {
+  speechrecorder::WavReader reader(path);
+  if (!reader.IsOpen()) {
+    return false;
+  }
+
+  processor.Reset();
+  const short* frame;
+  if (reader.SampleRate() == processor.options_.sampleRate) {
+    while ((frame = reader.Read(samplesPerFrame)) != nullptr) {
+      processor.Process(frame);
+    }
+
+    return true;
+  }
+
+  speechrecorder::Resampler resampler(reader.SampleRate(),
+                                      processor.options_.sampleRate);
+  std::vector<short> resampled;
+  size_t block = std::max(reader.SampleRate() / 100, 1);
+  while ((frame = reader.Read(block)) != nullptr) {
+    resampler.Process(frame, block, resampled);
+    size_t offset = 0;
+    for (; offset + samplesPerFrame <= resampled.size();
+         offset += samplesPerFrame) {
+      processor.Process(resampled.data() + offset);
+    }
+
+    resampled.erase(resampled.begin(), resampled.begin() + offset);
+  }
+
+  return true;
+}
 
 Napi::Object SpeechRecorder::Init(Napi::Env env, Napi::Object exports) {
   Napi::Function f = DefineClass(
       env, "SpeechRecorder",
       {
+          InstanceMethod<&SpeechRecorder::ProcessBuffer>(
+              "processBuffer", static_cast<napi_property_attributes>(
+                                   napi_writable | napi_configurable)),
           InstanceMethod<&SpeechRecorder::ProcessFile>(
               "processFile", static_cast<napi_property_attributes>(
                                  napi_writable | napi_configurable)),
+          InstanceMethod<&SpeechRecorder::ProcessFileAsync>(
+              "processFileAsync", static_cast<napi_property_attributes>(
+                                      napi_writable | napi_configurable)),
+          InstanceMethod<&SpeechRecorder::ProcessFiles>(
+              "processFiles", static_cast<napi_property_attributes>(
+                                  napi_writable | napi_configurable)),
+          InstanceMethod<&SpeechRecorder::Push>(
+              "push", static_cast<napi_property_attributes>(napi_writable |
+                                                            napi_configurable)),
           InstanceMethod<&SpeechRecorder::Start>(
               "start", static_cast<napi_property_attributes>(
                            napi_writable | napi_configurable)),
+          InstanceMethod<&SpeechRecorder::Stats>(
+              "stats", static_cast<napi_property_attributes>(
+                           napi_writable | napi_configurable)),
           InstanceMethod<&SpeechRecorder::Stop>(
               "stop", static_cast<napi_property_attributes>(napi_writable |
                                                             napi_configurable)),
@@ -43,151 +156,298 @@ Napi::Object SpeechRecorder::Init(Napi::Env env, Napi::Object exports) {
 SpeechRecorder::SpeechRecorder(const Napi::CallbackInfo& info)
     : Napi::ObjectWrap<SpeechRecorder>(info),
       stopped_(true),
-      queue_(),
       callback_(Napi::Persistent(info[1].As<Napi::Function>())),
       threadSafeFunctionCallback_([&](Napi::Env env, Napi::Function jsCallback,
-                                      SpeechRecorderCallbackData* data) {
-        Napi::Object object = Napi::Object::New(env);
-        object.Set("speaking", Napi::Boolean::New(env, data->speaking));
-        object.Set("volume", Napi::Number::New(env, data->volume));
-        object.Set("speech", Napi::Boolean::New(env, data->speech));
-        object.Set("probability", Napi::Number::New(env, data->probability));
-        object.Set("consecutiveSilence",
-                   Napi::Number::New(env, (double)data->consecutiveSilence));
-
-        if (data->audio.size() > 0) {
-          Napi::Int16Array buffer =
-              Napi::Int16Array::New(env, data->audio.size());
-          for (size_t i = 0; i < data->audio.size(); i++) {
-            buffer[i] = data->audio[i];
-          }
+                                      SpeechRecorderCallbackBatch* batch) {
+        // events from different devices are interleaved, so they're grouped
+        // by device first, keeping each device's events in order, so that
+        // audio batches don't mix devices.
+        if (processors_.size() > 1) {
+          std::stable_sort(batch->events.begin(), batch->events.end(),
+                           [](SpeechRecorderCallbackData* a,
+                              SpeechRecorderCallbackData* b) {
+                             return a->device < b->device;
+                           });
+        }
 
-          object.Set("audio", buffer);
+        size_t i = 0;
+        while (i < batch->events.size()) {
+          if (batchFrames_ > 1 && batch->events[i]->event == "audio") {
+            size_t end = i;
+            while (end < batch->events.size() &&
+                   batch->events[end]->event == "audio" &&
+                   batch->events[end]->device == batch->events[i]->device) {
+              end++;
+            }
+
+            DispatchAudioBatch(env, jsCallback, batch->events.data() + i,
+                               end - i);
+            i = end;
+          } else {
+            Dispatch(env, jsCallback, batch->events[i],
+                     PoolFor(batch->events[i]->device));
+            i++;
+          }
         }
 
-        jsCallback.Call({Napi::String::New(env, data->event), object});
-        delete data;
+        batchPool_.Release(batch);
       }),
+      batchFrames_(info[2]
+                       .As<Napi::Object>()
+                       .Get("batchFrames")
+                       .As<Napi::Number>()
+                       .Int32Value()),
+      batchLatency_(info[2]
+                        .As<Napi::Object>()
+                        .Get("batchLatency")
+                        .As<Napi::Number>()
+                        .Int32Value()),
+      externalBuffers_(info[2]
+                           .As<Napi::Object>()
+                           .Get("externalBuffers")
+                           .As<Napi::Boolean>()
+                           .Value()),
       modelPath_(info[0].As<Napi::String>().Utf8Value()),
-      options_({
-          info[2]
-              .As<Napi::Object>()
-              .Get("consecutiveFramesForSilence")
-              .As<Napi::Number>()
-              .Int32Value(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("consecutiveFramesForSpeaking")
-              .As<Napi::Number>()
-              .Int32Value(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("device")
-              .As<Napi::Number>()
-              .Int32Value(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("leadingBufferFrames")
-              .As<Napi::Number>()
-              .Int32Value(),
-          [&](std::vector<short> audio) {
-            SpeechRecorderCallbackData* data = new SpeechRecorderCallbackData();
-            data->event = "chunkStart";
-            data->audio = audio;
-            queue_.enqueue(data);
-          },
-          [&](std::vector<short> audio, bool speaking, double volume,
-              bool speech, double probability, int consecutiveSilence) {
-            SpeechRecorderCallbackData* data = new SpeechRecorderCallbackData();
-            data->event = "audio";
-            data->audio = audio;
-            data->speaking = speaking;
-            data->volume = volume;
-            data->speech = speech;
-            data->probability = probability;
-            data->consecutiveSilence = consecutiveSilence;
-            queue_.enqueue(data);
-          },
-          [&]() {
-            SpeechRecorderCallbackData* data = new SpeechRecorderCallbackData();
-            data->event = "chunkEnd";
-            queue_.enqueue(data);
+      options_(CreateOptions(info[2].As<Napi::Object>())) {
+  Napi::Object object = info[2].As<Napi::Object>();
+  Napi::Array devices = object.Get("devices").As<Napi::Array>();
+  for (uint32_t i = 0; i < devices.Length(); i++) {
+    devices_.push_back(devices.Get(i).As<Napi::Number>().Int32Value());
+  }
+
+  if (devices_.empty()) {
+    devices_.push_back(options_.device);
+  }
+
+  // capturing the same device twice would only duplicate its events.
+  std::vector<int> unique;
+  for (int device : devices_) {
+    if (std::find(unique.begin(), unique.end(), device) == unique.end()) {
+      unique.push_back(device);
+    }
+  }
+
+  devices_ = unique;
+
+  // every device gets its own processor, and their events are merged into
+  // one stream. unless silero batching was set up explicitly, requests from
+  // all of the devices are batched. processors wait for silero once per hop,
+  // so a device that's speaking on its own can't afford to wait long for the
+  // others: a batch runs as soon as every device is in it, or after 2 ms.
+  speechrecorder::ChunkProcessorOptions options = options_;
+  if (devices_.size() > 1 && options.sileroVadBatchWindow == 0) {
+    options.sileroVadBatchWindow = 2;
+    options.sileroVadBatchSize =
+        std::min(options.sileroVadBatchSize, (int)devices_.size());
+  }
+
+  for (int device : devices_) {
+    queues_.push_back(
+        std::make_unique<ReaderWriterQueue<SpeechRecorderCallbackData*>>());
+    pools_.push_back(
+        std::make_shared<speechrecorder::Pool<SpeechRecorderCallbackData>>());
+    ReaderWriterQueue<SpeechRecorderCallbackData*>* queue =
+        queues_.back().get();
+    options.device = device;
+    SetEventCallbacks(options, pools_.back().get(), device,
+                      [this, queue](SpeechRecorderCallbackData* data) {
+                        queue->enqueue(data);
+                        ready_.signal();
+                      });
+    processors_.push_back(std::make_unique<speechrecorder::ChunkProcessor>(
+        modelPath_, options, CreateSource(object, options)));
+  }
+}
+
+std::shared_ptr<speechrecorder::Pool<SpeechRecorderCallbackData>>&
+SpeechRecorder::PoolFor(int device) {
+  size_t index =
+      std::find(devices_.begin(), devices_.end(), device) - devices_.begin();
+  return pools_[std::min(index, pools_.size() - 1)];
+}
+
+void SpeechRecorder::Dispatch(
+    Napi::Env env, Napi::Function jsCallback, SpeechRecorderCallbackData* data,
+    std::shared_ptr<speechrecorder::Pool<SpeechRecorderCallbackData>> pool) {
+  Napi::Object object = Napi::Object::New(env);
+  if (data->device != INT_MIN) {
+    object.Set("device", Napi::Number::New(env, data->device));
+  }
+
+  object.Set("speaking", Napi::Boolean::New(env, data->speaking));
+  object.Set("volume", Napi::Number::New(env, data->volume));
+  object.Set("speech", Napi::Boolean::New(env, data->speech));
+  object.Set("probability", Napi::Number::New(env, data->probability));
+  object.Set("consecutiveSilence",
+             Napi::Number::New(env, (double)data->consecutiveSilence));
+
+  bool retained = false;
+  if (data->audio.size() > 0) {
+    if (externalBuffers_) {
+      // hand the pooled samples to JS without copying. the callback
+      // data goes back to the pool once the array buffer is collected.
+      Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(
+          env, data->audio.data(), data->audio.size() * sizeof(short),
+          [pool](Napi::Env env, void* audio,
+                 SpeechRecorderCallbackData* hint) {
+            pool->Release(hint);
           },
-          info[2]
-              .As<Napi::Object>()
-              .Get("samplesPerFrame")
-              .As<Napi::Number>()
-              .Int32Value(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("sampleRate")
-              .As<Napi::Number>()
-              .Int32Value(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("sileroVadBufferSize")
-              .As<Napi::Number>()
-              .Int32Value(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("sileroVadRateLimit")
-              .As<Napi::Number>()
-              .Int32Value(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("sileroVadSilenceThreshold")
-              .As<Napi::Number>()
-              .DoubleValue(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("sileroVadSpeakingThreshold")
-              .As<Napi::Number>()
-              .DoubleValue(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("webrtcVadLevel")
-              .As<Napi::Number>()
-              .Int32Value(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("webrtcVadBufferSize")
-              .As<Napi::Number>()
-              .Int32Value(),
-          info[2]
-              .As<Napi::Object>()
-              .Get("webrtcVadResultsSize")
-              .As<Napi::Number>()
-              .Int32Value(),
-      }),
-      processor_(modelPath_, options_) {}
+          data);
+      object.Set("audio", Napi::Int16Array::New(env, data->audio.size(),
+                                                arrayBuffer, 0));
+      retained = true;
+    } else {
+      object.Set("audio", CopyAudio(env, data->audio.data(),
+                                    data->audio.size()));
+    }
+  }
 
-void SpeechRecorder::ProcessFile(const Napi::CallbackInfo& info) {
-  Napi::Env env = info.Env();
-  std::string path = info[0].As<Napi::String>().Utf8Value();
+  jsCallback.Call({Napi::String::New(env, data->event), object});
+  if (!retained) {
+    pool->Release(data);
+  }
+}
+
+void SpeechRecorder::DispatchAudioBatch(Napi::Env env,
+                                        Napi::Function jsCallback,
+                                        SpeechRecorderCallbackData** events,
+                                        size_t count) {
+  int device = events[0]->device;
+  speechrecorder::Pool<SpeechRecorderCallbackData>& pool = *PoolFor(device);
+  size_t samples = 0;
+  for (size_t i = 0; i < count; i++) {
+    samples += events[i]->audio.size();
+  }
+
+  Napi::Int16Array audio = Napi::Int16Array::New(env, samples);
+  Napi::Float64Array volume = Napi::Float64Array::New(env, count);
+  Napi::Float64Array probability = Napi::Float64Array::New(env, count);
+  Napi::Uint8Array speaking = Napi::Uint8Array::New(env, count);
+  Napi::Uint8Array speech = Napi::Uint8Array::New(env, count);
+  Napi::Int32Array consecutiveSilence = Napi::Int32Array::New(env, count);
+
+  short* output = audio.Data();
+  for (size_t i = 0; i < count; i++) {
+    SpeechRecorderCallbackData* data = events[i];
+    std::memcpy(output, data->audio.data(), data->audio.size() * sizeof(short));
+    output += data->audio.size();
+    volume.Data()[i] = data->volume;
+    probability.Data()[i] = data->probability;
+    speaking.Data()[i] = data->speaking;
+    speech.Data()[i] = data->speech;
+    consecutiveSilence.Data()[i] = data->consecutiveSilence;
+    pool.Release(data);
+  }
+
+  Napi::Object object = Napi::Object::New(env);
+  object.Set("device", Napi::Number::New(env, device));
+  object.Set("frames", Napi::Number::New(env, (double)count));
+  object.Set("audio", audio);
+  object.Set("volume", volume);
+  object.Set("probability", probability);
+  object.Set("speaking", speaking);
+  object.Set("speech", speech);
+  object.Set("consecutiveSilence", consecutiveSilence);
+  jsCallback.Call({Napi::String::New(env, "audioBatch"), object});
+}
+
+speechrecorder::ChunkProcessorOptions SpeechRecorder::CreateOptions(
+    Napi::Object object) {
+  speechrecorder::ChunkProcessorOptions options;
+  options.captureBufferFrames =
+      object.Get("captureBufferFrames").As<Napi::Number>().Int32Value();
+  std::string captureOverflow =
+      object.Get("captureOverflow").As<Napi::String>().Utf8Value();
+  if (captureOverflow == "dropOldest") {
+    options.captureOverflow = speechrecorder::OverflowPolicy::DropOldest;
+  } else if (captureOverflow == "dropNewest") {
+    options.captureOverflow = speechrecorder::OverflowPolicy::DropNewest;
+  } else if (captureOverflow == "grow") {
+    options.captureOverflow = speechrecorder::OverflowPolicy::Grow;
+  } else {
+    throw Napi::TypeError::New(
+        object.Env(),
+        "Expected captureOverflow to be dropOldest, dropNewest, or grow");
+  }
+
+  options.captureSampleRate =
+      object.Get("captureSampleRate").As<Napi::Number>().Int32Value();
+  options.consecutiveFramesForSilence =
+      object.Get("consecutiveFramesForSilence").As<Napi::Number>().Int32Value();
+  options.consecutiveFramesForSpeaking =
+      object.Get("consecutiveFramesForSpeaking")
+          .As<Napi::Number>()
+          .Int32Value();
+  options.device = object.Get("device").As<Napi::Number>().Int32Value();
+  options.leadingBufferFrames =
+      object.Get("leadingBufferFrames").As<Napi::Number>().Int32Value();
+  options.samplesPerFrame =
+      object.Get("samplesPerFrame").As<Napi::Number>().Int32Value();
+  options.sampleRate = object.Get("sampleRate").As<Napi::Number>().Int32Value();
+  options.sileroVadBatchSize =
+      object.Get("sileroVadBatchSize").As<Napi::Number>().Int32Value();
+  options.sileroVadBatchWindow =
+      object.Get("sileroVadBatchWindow").As<Napi::Number>().Int32Value();
+  options.sileroVadBufferSize =
+      object.Get("sileroVadBufferSize").As<Napi::Number>().Int32Value();
+  options.sileroVadRateLimit =
+      object.Get("sileroVadRateLimit").As<Napi::Number>().Int32Value();
+  options.sileroVadSessions =
+      object.Get("sileroVadSessions").As<Napi::Number>().Int32Value();
+  options.sileroVadSilenceThreshold =
+      object.Get("sileroVadSilenceThreshold").As<Napi::Number>().DoubleValue();
+  options.sileroVadSpeakingThreshold =
+      object.Get("sileroVadSpeakingThreshold").As<Napi::Number>().DoubleValue();
+  options.webrtcVadLevel =
+      object.Get("webrtcVadLevel").As<Napi::Number>().Int32Value();
+  options.webrtcVadBufferSize =
+      object.Get("webrtcVadBufferSize").As<Napi::Number>().Int32Value();
+  options.webrtcVadResultsSize =
+      object.Get("webrtcVadResultsSize").As<Napi::Number>().Int32Value();
+  return options;
+}
 
+std::unique_ptr<speechrecorder::AudioSource> SpeechRecorder::CreateSource(
+    Napi::Object object, const speechrecorder::ChunkProcessorOptions& options) {
+  // a replay stands in for the microphone, so raw audio is read at the rate
+  // the microphone would have captured at.
+  std::string replayFile =
+      object.Get("replayFile").As<Napi::String>().Utf8Value();
+  if (!replayFile.empty()) {
+    return std::make_unique<speechrecorder::ReplaySource>(
+        replayFile, options.samplesPerFrame, options.sampleRate,
+        options.captureSampleRate,
+        object.Get("replaySpeed").As<Napi::Number>().DoubleValue());
+  }
+
+  return std::make_unique<speechrecorder::Microphone>(
+      options.device, options.samplesPerFrame, options.sampleRate,
+      options.captureSampleRate);
+}
+
+speechrecorder::ChunkProcessor& SpeechRecorder::InlineProcessor() {
   // we don't want to create two processors on startup, because loading the
-  // silero model is expensive, so lazily create this instance only if this
-  // method is actually called (which is probably not common)
-  if (!processFileProcessor_) {
+  // silero model is expensive, so lazily create this instance only if it's
+  // actually used (which is probably not common). its callbacks call JS
+  // directly, so it's only ever run on the main thread.
+  if (!inlineProcessor_) {
     speechrecorder::ChunkProcessorOptions options = options_;
+    Napi::Env env = callback_.Env();
 
-    options.onChunkStart = [&](std::vector<short> audio) {
+    options.onChunkStartView = [this, env](
+                                   speechrecorder::Span<const short> audio) {
       Napi::Object object = Napi::Object::New(env);
       if (audio.size() > 0) {
-        Napi::Int16Array buffer = Napi::Int16Array::New(env, audio.size());
-        for (size_t i = 0; i < audio.size(); i++) {
-          buffer[i] = audio[i];
-        }
-
-        object.Set("audio", buffer);
+        object.Set("audio", CopyAudio(env, audio.data(), audio.size()));
       }
 
       callback_.Value().Call({Napi::String::New(env, "chunkStart"), object});
     };
 
-    options.onAudio = [&](std::vector<short> audio, bool speaking,
-                          double volume, bool speech, double probability,
-                          int consecutiveSilence) {
+    options.onAudioView = [this, env](speechrecorder::Span<const short> audio,
+                                      bool speaking, double volume,
+                                      bool speech, double probability,
+                                      int consecutiveSilence) {
       Napi::Object object = Napi::Object::New(env);
       object.Set("speaking", Napi::Boolean::New(env, speaking));
       object.Set("volume", Napi::Number::New(env, volume));
@@ -197,46 +457,318 @@ void SpeechRecorder::ProcessFile(const Napi::CallbackInfo& info) {
                  Napi::Number::New(env, (double)consecutiveSilence));
 
       if (audio.size() > 0) {
-        Napi::Int16Array buffer = Napi::Int16Array::New(env, audio.size());
-        for (size_t i = 0; i < audio.size(); i++) {
-          buffer[i] = audio[i];
-        }
-
-        object.Set("audio", buffer);
+        object.Set("audio", CopyAudio(env, audio.data(), audio.size()));
         callback_.Value().Call({Napi::String::New(env, "audio"), object});
       }
     };
 
-    options.onChunkEnd = [&] {
-      callback_.Value().Call({Napi::String::New(env, "chunkEnd")});
+    options.onChunkEnd = [this, env] {
+      callback_.Value().Call(
+          {Napi::String::New(env, "chunkEnd"), Napi::Object::New(env)});
     };
 
-    processFileProcessor_ =
+    inlineProcessor_ =
         std::make_unique<speechrecorder::ChunkProcessor>(modelPath_, options);
   }
 
-  unsigned int channels;
-  unsigned int sampleRate;
-  drwav_uint64 frames;
-  short* data = drwav_open_file_and_read_pcm_frames_s16(
-      path.c_str(), &channels, &sampleRate, &frames, nullptr);
+  return *inlineProcessor_;
+}
+
+void SpeechRecorder::ProcessBuffer(const Napi::CallbackInfo& info) {
+  InlineProcessor().Reset();
+  pushBuffer_.clear();
+  pushResampler_.reset();
+  pushInterleaved_.clear();
+  PushSamples(info.Env(), info[0], info[1].As<Napi::Number>().Int32Value(),
+              info[2].As<Napi::Number>().Int32Value());
+
+  // like files, a trailing partial frame is dropped.
+  pushBuffer_.clear();
+}
+
+void SpeechRecorder::ProcessFile(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::string path = info[0].As<Napi::String>().Utf8Value();
+  pushBuffer_.clear();
+  pushResampler_.reset();
+  pushInterleaved_.clear();
+  if (!ReadFile(InlineProcessor(), path, options_.samplesPerFrame)) {
+    throw Napi::Error::New(env, "Unable to read " + path);
+  }
+}
 
-  processFileProcessor_->Reset();
-  int size = (int)frames;
-  for (int i = 0; i < size; i += options_.samplesPerFrame) {
-    std::vector<short> buffer;
-    for (int j = 0; j < options_.samplesPerFrame; j++) {
-      if (i + j < size) {
-        buffer.push_back(data[i + j]);
+Napi::Value SpeechRecorder::ProcessFileAsync(const Napi::CallbackInfo& info) {
+  ProcessFileJob* job = new ProcessFileJob(info.Env());
+  job->path = info[0].As<Napi::String>().Utf8Value();
+  job->recorder = this;
+
+  // keep the recorder alive until the job's last event has been dispatched.
+  Ref();
+  job->threadSafeFunction = Napi::ThreadSafeFunction::New(
+      info.Env(), callback_.Value(), "Speech Recorder Process File", 4, 1, job,
+      [](Napi::Env env, ProcessFileJob* job) {
+        job->thread.join();
+        job->recorder->Unref();
+        if (job->failed) {
+          job->deferred.Reject(
+              Napi::Error::New(env, "Unable to read " + job->path).Value());
+        } else {
+          job->deferred.Resolve(env.Undefined());
+        }
+
+        delete job;
+      });
+
+  // each job gets its own processor, so several files can be in flight at
+  // once. events are handed to JS in batches, and the bounded queue keeps a
+  // fast decoder from getting too far ahead of the main thread. the processor
+  // is constructed here rather than on the job's thread, so it's never
+  // constructed alongside the recorder's own processors.
+  std::function<void(Napi::Env, Napi::Function, SpeechRecorderCallbackBatch*)>
+      deliver = [this, job](Napi::Env env, Napi::Function jsCallback,
+                            SpeechRecorderCallbackBatch* batch) {
+        for (SpeechRecorderCallbackData* data : batch->events) {
+          Dispatch(env, jsCallback, data, job->pool);
+        }
+
+        job->batchPool.Release(batch);
+      };
+
+  speechrecorder::ChunkProcessorOptions options = options_;
+  SetEventCallbacks(options, job->pool.get(), INT_MIN,
+                    [job, deliver](SpeechRecorderCallbackData* data) {
+                      job->batch->events.push_back(data);
+                      if (job->batch->events.size() >= 32) {
+                        job->threadSafeFunction.BlockingCall(job->batch,
+                                                             deliver);
+                        job->batch = job->batchPool.Acquire();
+                        job->batch->events.clear();
+                      }
+                    });
+  job->processor =
+      std::make_unique<speechrecorder::ChunkProcessor>(modelPath_, options);
+
+  job->thread = std::thread([job, deliver] {
+    job->batch = job->batchPool.Acquire();
+    job->batch->events.clear();
+    job->failed = !ReadFile(*job->processor, job->path,
+                            job->processor->options_.samplesPerFrame);
+
+    // the last batch is always delivered, even if it's empty, so that batches
+    // are only ever released on the main thread.
+    job->threadSafeFunction.BlockingCall(job->batch, deliver);
+    job->threadSafeFunction.Release();
+  });
+
+  return job->deferred.Promise();
+}
+
+Napi::Value SpeechRecorder::ProcessFiles(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Array paths = info[0].As<Napi::Array>();
+  int concurrency = info[1].As<Napi::Number>().Int32Value();
+  if (concurrency <= 0) {
+    concurrency = std::max((int)std::thread::hardware_concurrency(), 1);
+  }
+
+  ProcessFilesJob* job = new ProcessFilesJob(env);
+  for (uint32_t i = 0; i < paths.Length(); i++) {
+    job->paths.push_back(paths.Get(i).As<Napi::String>().Utf8Value());
+  }
+
+  job->segments.resize(job->paths.size());
+  job->failed.resize(job->paths.size(), 0);
+  job->recorder = this;
+  concurrency = std::min(concurrency, (int)job->paths.size());
+  if (concurrency == 0) {
+    Napi::Promise result = job->deferred.Promise();
+    job->deferred.Resolve(Napi::Array::New(env));
+    delete job;
+    return result;
+  }
+
+  Ref();
+  job->threadSafeFunction = Napi::ThreadSafeFunction::New(
+      env, "Speech Recorder Process Files", 0, concurrency, job,
+      [](Napi::Env env, ProcessFilesJob* job) {
+        for (std::thread& thread : job->threads) {
+          thread.join();
+        }
+
+        Napi::Array result = Napi::Array::New(env, job->paths.size());
+        for (size_t i = 0; i < job->paths.size(); i++) {
+          Napi::Object file = Napi::Object::New(env);
+          file.Set("file", job->paths[i]);
+          if (job->failed[i]) {
+            file.Set("error", "Unable to read " + job->paths[i]);
+          } else {
+            Napi::Array segments =
+                Napi::Array::New(env, job->segments[i].size());
+            for (size_t j = 0; j < job->segments[i].size(); j++) {
+              Napi::Object segment = Napi::Object::New(env);
+              segment.Set("start", job->segments[i][j].first);
+              segment.Set("end", job->segments[i][j].second);
+              segments[j] = segment;
+            }
+
+            file.Set("segments", segments);
+          }
+
+          result[i] = file;
+        }
+
+        job->processors.clear();
+        job->recorder->Unref();
+        job->deferred.Resolve(result);
+        delete job;
+      });
+
+  // each worker has its own processor, and the processors share a pool of
+  // sessions as large as the worker count, so workers don't wait on each
+  // other's inference. a segment starts with the frame that begins a chunk
+  // and ends with the frame that ends it, or with the end of the file.
+  speechrecorder::ChunkProcessorOptions options = options_;
+  options.sileroVadSessions = std::max(options.sileroVadSessions, concurrency);
+  job->workers.resize(concurrency);
+  for (int i = 0; i < concurrency; i++) {
+    ProcessFilesWorker* worker = &job->workers[i];
+    double sampleRate = (double)options.sampleRate;
+    options.onChunkStart = nullptr;
+    options.onChunkStartView = [worker, sampleRate](
+                                   speechrecorder::Span<const short> audio) {
+      worker->segments->push_back({worker->samples / sampleRate, -1.0});
+    };
+    options.onAudio = nullptr;
+    options.onAudioView = [worker](speechrecorder::Span<const short> audio,
+                                   bool speaking, double volume, bool speech,
+                                   double probability, int consecutiveSilence) {
+      worker->samples += audio.size();
+    };
+    options.onChunkEnd = [worker, sampleRate]() {
+      worker->segments->back().second = worker->samples / sampleRate;
+    };
+
+    job->processors.push_back(
+        std::make_unique<speechrecorder::ChunkProcessor>(modelPath_, options));
+  }
+
+  for (int i = 0; i < concurrency; i++) {
+    job->threads.push_back(std::thread([job, i] {
+      ProcessFilesWorker& worker = job->workers[i];
+      speechrecorder::ChunkProcessor& processor = *job->processors[i];
+      double sampleRate = (double)processor.options_.sampleRate;
+      while (true) {
+        size_t index = job->next++;
+        if (index >= job->paths.size()) {
+          break;
+        }
+
+        worker.segments = &job->segments[index];
+        worker.samples = 0;
+        job->failed[index] = !ReadFile(processor, job->paths[index],
+                                       processor.options_.samplesPerFrame);
+        if (!worker.segments->empty() &&
+            worker.segments->back().second < 0.0) {
+          worker.segments->back().second = worker.samples / sampleRate;
+        }
       }
+
+      job->threadSafeFunction.Release();
+    }));
+  }
+
+  return job->deferred.Promise();
+}
+
+void SpeechRecorder::Push(const Napi::CallbackInfo& info) {
+  PushSamples(info.Env(), info[0], info[1].As<Napi::Number>().Int32Value(),
+              info[2].As<Napi::Number>().Int32Value());
+}
+
+void SpeechRecorder::PushSamples(Napi::Env env, Napi::Value value,
+                                 int sampleRate, int channels) {
+  if (sampleRate <= 0 || channels <= 0) {
+    throw Napi::RangeError::New(
+        env, "Expected a positive sample rate and channel count");
+  }
+
+  if (!value.IsTypedArray()) {
+    throw Napi::TypeError::New(env, "Expected an Int16Array or Float32Array");
+  }
+
+  const short* samples;
+  size_t size;
+  Napi::TypedArray array = value.As<Napi::TypedArray>();
+  if (array.TypedArrayType() == napi_int16_array) {
+    samples = value.As<Napi::Int16Array>().Data();
+    size = array.ElementLength();
+  } else if (array.TypedArrayType() == napi_float32_array) {
+    const float* floats = value.As<Napi::Float32Array>().Data();
+    size = array.ElementLength();
+    pushConversion_.resize(size);
+    for (size_t i = 0; i < size; i++) {
+      float sample = std::min(std::max(floats[i], -1.0f), 1.0f);
+      pushConversion_[i] = (short)(sample * SHRT_MAX);
     }
 
-    if (buffer.size() == (size_t)options_.samplesPerFrame) {
-      processFileProcessor_->Process(buffer.data());
+    samples = pushConversion_.data();
+  } else {
+    throw Napi::TypeError::New(env, "Expected an Int16Array or Float32Array");
+  }
+
+  // the resampler is kept across pushes, so its filter state carries over
+  // from one chunk to the next. a chunk can also end partway through an
+  // interleaved frame, in which case the start of that frame is kept until
+  // the rest of it arrives.
+  if (sampleRate != options_.sampleRate || channels != 1) {
+    if (!pushResampler_ || pushResampler_->InputRate() != sampleRate ||
+        pushResampler_->Channels() != channels) {
+      pushResampler_ = std::make_unique<speechrecorder::Resampler>(
+          sampleRate, options_.sampleRate, channels);
+      pushInterleaved_.clear();
     }
+
+    if (!pushInterleaved_.empty()) {
+      pushInterleaved_.insert(pushInterleaved_.end(), samples, samples + size);
+      samples = pushInterleaved_.data();
+      size = pushInterleaved_.size();
+    }
+
+    size_t frames = size / channels;
+    pushResampled_.clear();
+    pushResampler_->Process(samples, frames, pushResampled_);
+    if (samples == pushInterleaved_.data()) {
+      pushInterleaved_.erase(pushInterleaved_.begin(),
+                             pushInterleaved_.begin() + frames * channels);
+    } else {
+      pushInterleaved_.assign(samples + frames * channels, samples + size);
+    }
+
+    samples = pushResampled_.data();
+    size = pushResampled_.size();
+  }
+
+  // complete the partial frame left over from the last push, then process
+  // the rest of the frames in place, and keep whatever's left for next time.
+  speechrecorder::ChunkProcessor& processor = InlineProcessor();
+  size_t frame = options_.samplesPerFrame;
+  size_t offset = 0;
+  if (!pushBuffer_.empty()) {
+    offset = std::min(frame - pushBuffer_.size(), size);
+    pushBuffer_.insert(pushBuffer_.end(), samples, samples + offset);
+    if (pushBuffer_.size() < frame) {
+      return;
+    }
+
+    processor.Process(pushBuffer_.data());
+    pushBuffer_.clear();
   }
 
-  drwav_free(data, nullptr);
+  for (; offset + frame <= size; offset += frame) {
+    processor.Process(samples + offset);
+  }
+
+  pushBuffer_.assign(samples + offset, samples + size);
 }
 
 void SpeechRecorder::Start(const Napi::CallbackInfo& info) {
@@ -247,26 +779,133 @@ void SpeechRecorder::Start(const Napi::CallbackInfo& info) {
         thread_.join();
       });
 
+  // block until a processor produces an event, then drain everything that's
+  // pending so a burst of events costs a single call into JS. when audio is
+  // batched, audio events are held back until batchFrames have accumulated
+  // for each device, the oldest has waited batchLatency ms, or a chunk event
+  // arrives.
   thread_ = std::thread([&] {
-    while (!stopped_) {
+    SpeechRecorderCallbackBatch* batch = batchPool_.Acquire();
+    batch->events.clear();
+    int frames = 0;
+    std::chrono::steady_clock::time_point deadline;
+
+    while (true) {
+      bool stopped = stopped_;
+      std::chrono::microseconds timeout = std::chrono::milliseconds(100);
+      if (frames > 0 && batchLatency_ > 0) {
+        timeout = std::max(
+            std::chrono::microseconds(0),
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                deadline - std::chrono::steady_clock::now()));
+      }
+
       SpeechRecorderCallbackData* data;
-      bool element = queue_.try_dequeue(data);
-      if (element) {
-        threadSafeFunction_.BlockingCall(data, threadSafeFunctionCallback_);
+      bool flush = false;
+      if (!stopped && ready_.wait(timeout.count())) {
+        // one signal was taken to get here, and one more is taken for every
+        // other event that's drained. devices are drained in turn, and a
+        // batch stops taking events once it has batchFrames for each device,
+        // so a backlog can't make it any larger. events that are left behind
+        // keep their signals for the next batch.
+        int limit = batchFrames_ > 1 ? batchFrames_ * (int)processors_.size()
+                                     : INT_MAX;
+        size_t count = 0;
+        bool drained = false;
+        while (!drained && frames < limit) {
+          drained = true;
+          for (std::unique_ptr<ReaderWriterQueue<SpeechRecorderCallbackData*>>&
+                   queue : queues_) {
+            if (frames >= limit || !queue->try_dequeue(data)) {
+              continue;
+            }
+
+            drained = false;
+            if (count++ > 0) {
+              ready_.tryWait();
+            }
+
+            batch->events.push_back(data);
+            if (data->event == "audio") {
+              if (frames == 0) {
+                deadline = std::chrono::steady_clock::now() +
+                           std::chrono::milliseconds(batchLatency_);
+              }
+
+              frames++;
+            } else {
+              flush = true;
+            }
+          }
+        }
+      }
+
+      // the last batch is always delivered, even if it's empty, so that
+      // batches are only ever released on the main thread.
+      if (stopped) {
+        threadSafeFunction_.BlockingCall(batch, threadSafeFunctionCallback_);
+        break;
       }
 
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      flush = flush || frames >= batchFrames_ * (int)processors_.size() ||
+              (frames > 0 && batchLatency_ > 0 &&
+               std::chrono::steady_clock::now() >= deadline);
+      if (flush && batch->events.size() > 0) {
+        threadSafeFunction_.BlockingCall(batch, threadSafeFunctionCallback_);
+        batch = batchPool_.Acquire();
+        batch->events.clear();
+        frames = 0;
+      }
     }
 
     threadSafeFunction_.Release();
   });
 
-  processor_.Start();
+  for (std::unique_ptr<speechrecorder::ChunkProcessor>& processor :
+       processors_) {
+    processor->Start();
+  }
+}
+
+static Napi::Object CreateStats(Napi::Env env,
+                                const speechrecorder::FrameRingStats& stats) {
+  Napi::Object object = Napi::Object::New(env);
+  object.Set("frames", (double)stats.frames);
+  object.Set("overruns", (double)stats.overruns);
+  object.Set("underruns", (double)stats.underruns);
+  object.Set("depth", (double)stats.depth);
+  object.Set("capacity", (double)stats.capacity);
+  return object;
+}
+
+Napi::Value SpeechRecorder::Stats(const Napi::CallbackInfo& info) {
+  // the totals for every device, followed by each device on its own.
+  Napi::Env env = info.Env();
+  speechrecorder::FrameRingStats total;
+  Napi::Array devices = Napi::Array::New(env, processors_.size());
+  for (size_t i = 0; i < processors_.size(); i++) {
+    speechrecorder::FrameRingStats stats = processors_[i]->CaptureStats();
+    total.frames += stats.frames;
+    total.overruns += stats.overruns;
+    total.underruns += stats.underruns;
+    total.depth += stats.depth;
+    total.capacity += stats.capacity;
+    Napi::Object device = CreateStats(env, stats);
+    device.Set("device", devices_[i]);
+    devices[i] = device;
+  }
+
+  Napi::Object object = CreateStats(env, total);
+  object.Set("devices", devices);
+  return object;
 }
 
 void SpeechRecorder::Stop(const Napi::CallbackInfo& info) {
   stopped_ = true;
-  processor_.Stop();
+  for (std::unique_ptr<speechrecorder::ChunkProcessor>& processor :
+       processors_) {
+    processor->Stop();
+  }
 }
 
 Napi::Value GetDevices(const Napi::CallbackInfo& info) {